@@ -22,7 +22,5 @@
 #define RGB_MATRIX_SLEEP
 
 // Split sync settings
+// layer color and brightness reach the other half through users/luke/split_sync.c
 #define DRIVER_LED_TOTAL 44
-#define SPLIT_LED_STATE_ENABLE
-#define SPLIT_LAYER_STATE_ENABLE
-#define SPLIT_TRANSPORT_MIRROR
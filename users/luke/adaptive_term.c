@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "adaptive_term.h"
+#include <string.h>
+#include "settings.h"
+#include "print.h"
+#include "sched.h"
+
+/**
+ * Per key duration histograms
+ * Taps are presses that came out as the letter: real taps plus holds released without
+ * another key in between, which retro tapping turns back into the letter. Holds are presses
+ * that were used as a modifier; rolls counts the holds among them released within
+ * ADAPTIVE_TERM_ROLL_MS of the key that interrupted them. Counts saturate at 255, at which
+ * point the key's histograms are halved so old typing fades out and the learner keeps tracking.
+ */
+typedef struct {
+    uint8_t taps[ADAPTIVE_TERM_BUCKETS];
+    uint8_t holds[ADAPTIVE_TERM_BUCKETS];
+    uint8_t rolls;
+    uint8_t pending;
+} key_stats_t;
+
+static key_stats_t stats[HRM_SLOTS];
+static uint16_t    press_time[HRM_SLOTS];
+static uint16_t    interrupt_time[HRM_SLOTS]; // first other press while down
+static uint8_t     held;                      // slots currently down
+static uint8_t     interrupted;               // slots that saw another key press while down
+
+// 4 bits per slot, steps of ADAPTIVE_TERM_STEP below HRM_TAPPING_TERM, kept as SETTING_HRM_TERMS
+static uint32_t steps;
+
+static inline uint8_t get_step(uint8_t slot) {
+    return (steps >> (slot * 4)) & 0xF;
+}
+
+static inline void set_step(uint8_t slot, uint8_t step) {
+    steps = (steps & ~((uint32_t)0xF << (slot * 4))) | ((uint32_t)step << (slot * 4));
+}
+
+static uint32_t save(void);
+
+void adaptive_term_init(void) {
+    steps = settings_get_or(SETTING_HRM_TERMS, 0);
+    sched_arm(SCHED_ADAPTIVE_SAVE, ADAPTIVE_TERM_SAVE_INTERVAL, save);
+}
+
+uint16_t adaptive_term_get(uint8_t slot) {
+    return HRM_TAPPING_TERM - get_step(slot) * ADAPTIVE_TERM_STEP;
+}
+
+static void halve(key_stats_t *key) {
+    for (uint8_t i = 0; i < ADAPTIVE_TERM_BUCKETS; i++) {
+        key->taps[i] >>= 1;
+        key->holds[i] >>= 1;
+    }
+    key->rolls >>= 1;
+}
+
+static void add_sample(key_stats_t *key, uint8_t *hist, uint16_t duration) {
+    uint8_t bucket = duration / ADAPTIVE_TERM_BUCKET_MS;
+    if (bucket >= ADAPTIVE_TERM_BUCKETS) {
+        bucket = ADAPTIVE_TERM_BUCKETS - 1;
+    }
+
+    if (hist[bucket] == UINT8_MAX) {
+        halve(key);
+    }
+    hist[bucket]++;
+}
+
+/**
+ * Smallest term whose misfires stay within budget
+ * Lowering the term turns every tap longer than it into a hold, so walk the tap histogram
+ * from the top and stop at the lowest bucket edge where that tail is still affordable.
+ * Those holds never show up as taps again, only as rolls: they are spent from the budget
+ * first, and once they alone are over it the term backs off a step, using up half of them.
+ */
+static void evaluate(uint8_t slot) {
+    key_stats_t *key   = &stats[slot];
+    uint16_t     total = 0;
+
+    for (uint8_t i = 0; i < ADAPTIVE_TERM_BUCKETS; i++) {
+        total += key->taps[i] + key->holds[i];
+    }
+    if (total < ADAPTIVE_TERM_MIN_SAMPLES) {
+        return;
+    }
+
+    uint32_t budget = (uint32_t)total * ADAPTIVE_TERM_MISFIRE_PERMILLE / 1000;
+    if (key->rolls > budget) {
+        if (get_step(slot)) {
+            set_step(slot, get_step(slot) - 1);
+        }
+        key->rolls >>= 1;
+        return;
+    }
+    budget -= key->rolls;
+
+    uint32_t tail = 0;
+    uint8_t  edge = ADAPTIVE_TERM_BUCKETS;
+    while (edge > 0 && tail + key->taps[edge - 1] <= budget) {
+        tail += key->taps[--edge];
+    }
+
+    uint16_t target = edge * ADAPTIVE_TERM_BUCKET_MS;
+    if (target < ADAPTIVE_TERM_FLOOR) {
+        target = ADAPTIVE_TERM_FLOOR;
+    }
+    if (target > HRM_TAPPING_TERM) {
+        target = HRM_TAPPING_TERM;
+    }
+
+    // back off to the target at once, but only creep down a step per evaluation
+    uint16_t current = adaptive_term_get(slot);
+    if (target > current) {
+        set_step(slot, (HRM_TAPPING_TERM - target) / ADAPTIVE_TERM_STEP);
+    } else if (target + ADAPTIVE_TERM_STEP <= current) {
+        set_step(slot, get_step(slot) + 1);
+    }
+}
+
+void adaptive_term_record(uint16_t keycode, keyrecord_t *record) {
+    if (record->event.type != KEY_EVENT) {
+        return;
+    }
+
+    uint8_t slot = tap_hold_slot(keycode, record);
+    if (record->event.pressed) {
+        // any press interrupts the home row mods down, another home row mod too
+        uint8_t fresh = held & ~interrupted;
+        for (uint8_t i = 0; i < HRM_SLOTS; i++) {
+            if (fresh & (1 << i)) {
+                interrupt_time[i] = record->event.time;
+            }
+        }
+        interrupted |= held;
+    }
+    if (slot >= HRM_SLOTS) {
+        return;
+    }
+
+    uint8_t bit = 1 << slot;
+    if (record->event.pressed) {
+        press_time[slot] = record->event.time;
+        held |= bit;
+        interrupted &= ~bit;
+        return;
+    }
+    if (!(held & bit)) {
+        return;
+    }
+
+    key_stats_t *key      = &stats[slot];
+    uint16_t     duration = TIMER_DIFF_16(record->event.time, press_time[slot]);
+    bool         tap      = record->tap.count == 1 || (record->tap.count == 0 && !(interrupted & bit));
+
+    // a second tap within the quick tap term is auto-repeat, and a modifier held far past the
+    // term then released alone was abandoned rather than meant as a letter
+    bool abandoned = record->tap.count == 0 && tap && duration >= ADAPTIVE_TERM_BUCKETS * ADAPTIVE_TERM_BUCKET_MS;
+    if (record->tap.count <= 1 && !abandoned) {
+        add_sample(key, tap ? key->taps : key->holds, duration);
+        if (!tap && (interrupted & bit) && TIMER_DIFF_16(record->event.time, interrupt_time[slot]) < ADAPTIVE_TERM_ROLL_MS) {
+            if (key->rolls == UINT8_MAX) {
+                halve(key);
+            }
+            key->rolls++;
+        }
+        if (++key->pending >= ADAPTIVE_TERM_EVAL_EVERY) {
+            key->pending = 0;
+            evaluate(slot);
+        }
+    }
+
+    held &= ~bit;
+    interrupted &= ~bit;
+}
+
+/**
+ * Persistence
+ * Terms only move a step at a time, so hand them to the settings store at most once per
+ * ADAPTIVE_TERM_SAVE_INTERVAL; it skips the write when nothing changed
+ */
+static uint32_t save(void) {
+    settings_set(SETTING_HRM_TERMS, steps);
+    return ADAPTIVE_TERM_SAVE_INTERVAL;
+}
+
+void adaptive_term_reset(void) {
+    memset(stats, 0, sizeof(stats));
+    steps = 0;
+    settings_set(SETTING_HRM_TERMS, steps);
+}
+
+void adaptive_term_report(void) {
+    uprintf("adaptive terms ms:");
+    for (uint8_t slot = 0; slot < HRM_SLOTS; slot++) {
+        uprintf(" %u", adaptive_term_get(slot));
+    }
+    uprintf("\nsuspected roll holds:");
+    for (uint8_t slot = 0; slot < HRM_SLOTS; slot++) {
+        uprintf(" %u", stats[slot].rolls);
+    }
+    uprintf("\n");
+}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "tap_hold.h"
+
+// learned terms are HRM_TAPPING_TERM minus a 4 bit step count, so all eight fit in one setting
+#ifndef ADAPTIVE_TERM_STEP
+#    define ADAPTIVE_TERM_STEP 10
+#endif
+#ifndef ADAPTIVE_TERM_FLOOR
+#    define ADAPTIVE_TERM_FLOOR (HRM_TAPPING_TERM - 15 * ADAPTIVE_TERM_STEP)
+#endif
+
+// accepted share of presses that would have resolved the wrong way, in permille
+#ifndef ADAPTIVE_TERM_MISFIRE_PERMILLE
+#    define ADAPTIVE_TERM_MISFIRE_PERMILLE 20
+#endif
+
+// a hold released this soon after the next key went down was most likely a roll the term
+// cut short, counted against the misfire budget
+#ifndef ADAPTIVE_TERM_ROLL_MS
+#    define ADAPTIVE_TERM_ROLL_MS 60
+#endif
+
+// samples a key needs before its term moves, and how often it is re-evaluated after that
+#ifndef ADAPTIVE_TERM_MIN_SAMPLES
+#    define ADAPTIVE_TERM_MIN_SAMPLES 64
+#endif
+#ifndef ADAPTIVE_TERM_EVAL_EVERY
+#    define ADAPTIVE_TERM_EVAL_EVERY 16
+#endif
+
+// minimum time between saves of the learned terms
+#ifndef ADAPTIVE_TERM_SAVE_INTERVAL
+#    define ADAPTIVE_TERM_SAVE_INTERVAL 600000
+#endif
+
+#define ADAPTIVE_TERM_BUCKET_MS 10
+#define ADAPTIVE_TERM_BUCKETS   32
+
+_Static_assert(ADAPTIVE_TERM_FLOOR >= HRM_TAPPING_TERM - 15 * ADAPTIVE_TERM_STEP, "ADAPTIVE_TERM_FLOOR is below what 4 bit steps can reach");
+
+void     adaptive_term_init(void);
+uint16_t adaptive_term_get(uint8_t slot);
+void     adaptive_term_record(uint16_t keycode, keyrecord_t *record);
+void     adaptive_term_reset(void);
+void     adaptive_term_report(void);
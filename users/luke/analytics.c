@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "analytics.h"
+#include <string.h>
+#include "cycles.h"
+#include "layout.h"
+#include "print.h"
+#include "timer.h"
+
+_Static_assert((ANALYTICS_RING_SIZE & (ANALYTICS_RING_SIZE - 1)) == 0, "ANALYTICS_RING_SIZE must be a power of two");
+_Static_assert(MATRIX_ROWS <= 16 && MATRIX_COLS <= 16, "events pack the position into one byte");
+
+/**
+ * Press ring
+ * The record path only appends a 4 byte event; housekeeping drains and aggregates it.
+ * One producer and one consumer, each owning its own index, so no locking is needed.
+ */
+typedef struct {
+    uint8_t  key; // row << 4 | col
+    uint8_t  layer;
+    uint16_t time;
+} analytics_event_t;
+
+static analytics_event_t ring[ANALYTICS_RING_SIZE];
+static volatile uint8_t  ring_head; // written by analytics_record only
+static volatile uint8_t  ring_tail; // written by analytics_task only
+
+/**
+ * Aggregates
+ * Saturating counters, exported as is over raw hid, so the layout is part of the
+ * protocol with tools/analytics_collector.py; bump version on any change. Every field
+ * is naturally aligned, which keeps the counters addressable and the export padding free.
+ */
+#define ANALYTICS_VERSION 1
+
+typedef struct {
+    uint8_t  version;
+    uint8_t  rows;
+    uint8_t  cols;
+    uint8_t  layers;
+    uint32_t typing_ms;
+    uint32_t keys_typed;
+    uint32_t bigrams;
+    uint32_t same_finger;
+    uint32_t same_hand;
+    uint32_t dropped;
+    uint32_t record_calls;
+    uint32_t record_cycles;
+    uint32_t record_cycles_max;
+    uint32_t dwell_ms[LAYER_COUNT];
+    uint16_t presses[MATRIX_ROWS][MATRIX_COLS];
+} analytics_blob_t;
+
+_Static_assert(sizeof(analytics_blob_t) == 4 + 9 * 4 + LAYER_COUNT * 4 + MATRIX_ROWS * MATRIX_COLS * 2, "analytics_blob_t must not be padded");
+
+static analytics_blob_t blob;
+static uint8_t          last_key = 0xFF;
+static uint16_t         last_time;
+static uint32_t         dwell_timer;
+
+static inline void sat_inc16(uint16_t *counter) {
+    if (*counter < UINT16_MAX) {
+        (*counter)++;
+    }
+}
+
+static inline void sat_add32(uint32_t *counter, uint32_t value) {
+    *counter = *counter > UINT32_MAX - value ? UINT32_MAX : *counter + value;
+}
+
+static void reset(void) {
+    memset(&blob, 0, sizeof(blob));
+    blob.version = ANALYTICS_VERSION;
+    blob.rows    = MATRIX_ROWS;
+    blob.cols    = MATRIX_COLS;
+    blob.layers  = LAYER_COUNT;
+    last_key     = 0xFF;
+}
+
+void analytics_init(void) {
+    cycles_init();
+    reset();
+    dwell_timer = timer_read32();
+}
+
+// producer, from post_process_record_user; measures its own cost
+void analytics_record(keyrecord_t *record) {
+    uint32_t start = cycles_read();
+    keypos_t key   = record->event.key;
+
+    if (record->event.pressed && record->event.type == KEY_EVENT && key.row < MATRIX_ROWS && key.col < MATRIX_COLS) {
+        uint8_t head = ring_head;
+        uint8_t next = (head + 1) & (ANALYTICS_RING_SIZE - 1);
+        if (next == ring_tail) {
+            blob.dropped++;
+        } else {
+            ring[head] = (analytics_event_t){
+                .key   = key.row << 4 | key.col,
+                .layer = get_highest_layer(layer_state | default_layer_state),
+                .time  = record->event.time,
+            };
+            ring_head = next;
+        }
+
+        uint32_t cycles = cycles_since(start);
+        blob.record_calls++;
+        blob.record_cycles += cycles;
+        if (cycles > blob.record_cycles_max) {
+            blob.record_cycles_max = cycles;
+        }
+    }
+}
+
+static void aggregate(const analytics_event_t *event) {
+    uint8_t row    = event->key >> 4;
+    uint8_t col    = event->key & 0xF;
+    uint8_t finger = pgm_read_byte(&finger_table[row][col]);
+
+    sat_inc16(&blob.presses[row][col]);
+
+    if (last_key != 0xFF && event->layer == DFLT) {
+        uint16_t gap = TIMER_DIFF_16(event->time, last_time);
+        if (gap < ANALYTICS_IDLE_MS) {
+            sat_add32(&blob.typing_ms, gap);
+        }
+        if (gap < ANALYTICS_BIGRAM_MS) {
+            uint8_t last_finger = pgm_read_byte(&finger_table[last_key >> 4][last_key & 0xF]);
+            sat_add32(&blob.bigrams, 1);
+            if (finger == last_finger && event->key != last_key) {
+                sat_add32(&blob.same_finger, 1);
+            }
+            if ((finger <= F_LT) == (last_finger <= F_LT)) {
+                sat_add32(&blob.same_hand, 1);
+            }
+        }
+    }
+    if (event->layer == DFLT) {
+        sat_add32(&blob.keys_typed, 1);
+        last_key  = event->key;
+        last_time = event->time;
+    } else {
+        last_key = 0xFF;
+    }
+}
+
+// consumer, from housekeeping: drains the ring and charges elapsed time to the top layer
+void analytics_task(void) {
+    while (ring_tail != ring_head) {
+        uint8_t tail = ring_tail;
+        aggregate(&ring[tail]);
+        ring_tail = (tail + 1) & (ANALYTICS_RING_SIZE - 1);
+    }
+
+    uint32_t now = timer_read32();
+    if (now != dwell_timer) {
+        sat_add32(&blob.dwell_ms[get_highest_layer(layer_state | default_layer_state) % LAYER_COUNT], now - dwell_timer);
+        dwell_timer = now;
+    }
+}
+
+/**
+ * Raw hid export
+ * RAW_ANALYTICS_READ answers with up to RAW_EPSIZE - 5 bytes of the blob from the
+ * requested offset: [command, 0, size lo, size hi, count, data...]
+ */
+void analytics_raw(uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+        case RAW_ANALYTICS_READ: {
+            uint16_t offset = data[1] | data[2] << 8;
+            uint16_t count  = offset < sizeof(blob) ? MIN(sizeof(blob) - offset, (uint16_t)(length - 5)) : 0;
+
+            data[1] = 0;
+            data[2] = sizeof(blob) & 0xFF;
+            data[3] = sizeof(blob) >> 8;
+            data[4] = count;
+            memcpy(&data[5], (const uint8_t *)&blob + offset, count);
+            break;
+        }
+        case RAW_ANALYTICS_RESET:
+            reset();
+            data[1] = 0;
+            break;
+    }
+}
+
+void analytics_report(void) {
+    uprintf("analytics presses %lu dropped %lu record cycles avg %lu max %lu\n", blob.record_calls, blob.dropped, blob.record_calls ? blob.record_cycles / blob.record_calls : 0,
+            blob.record_cycles_max);
+}
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// presses waiting for aggregation, a power of two
+#ifndef ANALYTICS_RING_SIZE
+#    define ANALYTICS_RING_SIZE 64
+#endif
+
+// consecutive presses closer than this count as a bigram
+#ifndef ANALYTICS_BIGRAM_MS
+#    define ANALYTICS_BIGRAM_MS 1000
+#endif
+
+// gaps longer than this are pauses, not typing time
+#ifndef ANALYTICS_IDLE_MS
+#    define ANALYTICS_IDLE_MS 2000
+#endif
+
+// finger per matrix position, generated from LAYER_FINGERS in keymap.c
+extern const uint8_t PROGMEM finger_table[MATRIX_ROWS][MATRIX_COLS];
+
+void analytics_init(void);
+void analytics_record(keyrecord_t *record);
+void analytics_task(void);
+void analytics_raw(uint8_t *data, uint8_t length);
+void analytics_report(void);
@@ -0,0 +1,325 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "combo_engine.h"
+#include "action_tapping.h"
+#include "print.h"
+#include "sched.h"
+#include "timer.h"
+
+typedef uint64_t key_bits_t;
+
+_Static_assert(MATRIX_ROWS * MATRIX_COLS <= 64, "key sets are 64 bit masks");
+
+#define COMBO_OUTPUT(k, name, output, term, k1, k2, k3) [name] = output,
+#define COMBO_TERM(k, name, output, term, k1, k2, k3)   [name] = term,
+#define COMBO_SIZE(k, name, output, term, k1, k2, k3)   [name] = ((k1) != KC_NO) + ((k2) != KC_NO) + ((k3) != KC_NO),
+
+static const uint16_t PROGMEM combo_outputs[COMBO_COUNT] = {COMBO_SPEC(COMBO_OUTPUT, 0)};
+static const uint8_t PROGMEM  combo_terms[COMBO_COUNT]   = {COMBO_SPEC(COMBO_TERM, 0)};
+static const uint8_t PROGMEM  combo_sizes[COMBO_COUNT]   = {COMBO_SPEC(COMBO_SIZE, 0)};
+
+static key_bits_t combo_keys[COMBO_COUNT]; // every key of the combo, by matrix position
+static key_bits_t combo_held[COMBO_COUNT]; // keys of a fired combo that are still down
+static uint16_t   enabled;                 // combos whose keys were all found exactly once
+
+static keyrecord_t buffer[COMBO_BUFFER];
+static uint16_t    buffer_keycodes[COMBO_BUFFER];
+static uint8_t     buffered;
+static key_bits_t  buffered_keys;
+static uint16_t    candidates;
+static uint16_t    first_press;
+
+static key_bits_t tapping;          // tap-hold presses the core has not settled yet
+static uint16_t   tapping_deadline; // when the core settles the last of them at the latest
+static int8_t     waiting = -1;     // fired combo whose output waits for those
+static bool       waiting_up;       // its keys were already released
+static uint16_t   waiting_since;
+
+static struct {
+    uint32_t presses;
+    uint32_t passed;
+    uint32_t held_back;
+    uint32_t fired;
+    uint32_t settles;
+    uint32_t delay_sum;
+    uint16_t delay_max;
+    uint32_t deferred;
+    uint16_t defer_max;
+    uint32_t since;
+} stats;
+
+static inline key_bits_t key_bit(keypos_t key) {
+    return (key_bits_t)1 << (key.row * MATRIX_COLS + key.col);
+}
+
+/**
+ * Key sets
+ * Rebuilt from the generated combo_index; a combo whose keys are missing from the layout,
+ * or sit on it twice, is left disabled rather than firing on a partial chord
+ */
+void combo_engine_init(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint16_t members = pgm_read_word(&combo_index[row][col]);
+            for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+                if (members & (1 << i)) {
+                    combo_keys[i] |= key_bit((keypos_t){.row = row, .col = col});
+                }
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+        if (__builtin_popcountll(combo_keys[i]) == pgm_read_byte(&combo_sizes[i])) {
+            enabled |= 1 << i;
+        }
+    }
+    stats.since = timer_read32();
+}
+
+// combos are written against DFLT, anything layered on top plays through untouched
+static bool active(void) {
+    return get_highest_layer(layer_state | default_layer_state) == DFLT;
+}
+
+// candidates whose term has not run out at the given time
+static uint16_t live(uint16_t now) {
+    uint16_t elapsed = TIMER_DIFF_16(now, first_press);
+    uint16_t result  = 0;
+
+    for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+        if ((candidates & (1 << i)) && elapsed <= pgm_read_byte(&combo_terms[i])) {
+            result |= 1 << i;
+        }
+    }
+    return result;
+}
+
+static void settled(void) {
+    uint16_t delay = timer_elapsed(first_press);
+
+    stats.settles++;
+    stats.delay_sum += delay;
+    if (delay > stats.delay_max) {
+        stats.delay_max = delay;
+    }
+    buffered      = 0;
+    buffered_keys = 0;
+    candidates    = 0;
+    sched_cancel(SCHED_COMBO_TERM);
+}
+
+// a tap-hold press handed to the core, which settles it on its own schedule
+static void note_tapping(uint16_t keycode, keyrecord_t *record) {
+    if (IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode)) {
+        uint16_t deadline = record->event.time + get_tapping_term(keycode, record);
+        if (!tapping || TIMER_DIFF_16(deadline, tapping_deadline) < UINT16_MAX / 2) {
+            tapping_deadline = deadline;
+        }
+        tapping |= key_bit(record->event.key);
+    }
+}
+
+static uint32_t emit(void) {
+    if (waiting < 0) {
+        return 0;
+    }
+    uint16_t output = pgm_read_word(&combo_outputs[waiting]);
+    uint16_t wait   = timer_elapsed(waiting_since);
+
+    if (waiting_up) {
+        tap_code16(output);
+    } else {
+        register_code16(output);
+    }
+    if (wait > stats.defer_max) {
+        stats.defer_max = wait;
+    }
+    waiting = -1;
+    sched_cancel(SCHED_COMBO_OUTPUT);
+    return 0;
+}
+
+/**
+ * Fire
+ * The output is a plain key the host sees at once, so while a tap-hold key is still
+ * undecided it waits for that decision; otherwise a held home row mod would land after
+ * the combo it was meant to modify. Should the settled press never come back through
+ * post processing, the output goes out once the core must have decided anyway.
+ */
+static void fire(uint8_t combo) {
+    combo_held[combo] = combo_keys[combo];
+    stats.fired++;
+    settled();
+
+    // one output waits at a time, an older one goes out first
+    emit();
+    waiting       = combo;
+    waiting_up    = false;
+    waiting_since = timer_read();
+
+    uint16_t left = TIMER_DIFF_16(tapping_deadline, waiting_since);
+    if (!tapping || left >= UINT16_MAX / 2) {
+        // nothing undecided, or past the point where the core has decided it
+        tapping = 0;
+        emit();
+        return;
+    }
+    stats.deferred++;
+    sched_arm(SCHED_COMBO_OUTPUT, left + 1, emit);
+}
+
+/**
+ * Flush
+ * Replays the held back presses into the tap-hold machinery with their original event
+ * times, so home row mods and layer taps decide exactly as if nothing had waited
+ */
+static void flush(void) {
+    for (uint8_t i = 0; i < buffered; i++) {
+        note_tapping(buffer_keycodes[i], &buffer[i]);
+        action_tapping_process(buffer[i]);
+    }
+    settled();
+}
+
+// fires the combo the held keys make up, if the last of them landed within its term
+static void resolve(void) {
+    uint16_t ready = live(buffer[buffered - 1].event.time);
+
+    for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+        if ((ready & (1 << i)) && combo_keys[i] == buffered_keys) {
+            fire(i);
+            return;
+        }
+    }
+    flush();
+}
+
+static uint32_t term_expired(void) {
+    if (buffered) {
+        resolve();
+    }
+    return 0;
+}
+
+// fire at once only when no longer combo could still grow out of the held keys
+static void try_complete(uint16_t now) {
+    uint16_t ready    = live(now);
+    int8_t   complete = -1;
+
+    for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+        if (!(ready & (1 << i))) {
+            continue;
+        }
+        if (combo_keys[i] == buffered_keys) {
+            complete = i;
+        } else {
+            return;
+        }
+    }
+    if (complete >= 0) {
+        fire(complete);
+    }
+}
+
+static void hold_back(uint16_t keycode, keyrecord_t *record) {
+    buffer_keycodes[buffered] = keycode;
+    buffer[buffered++]        = *record;
+    buffered_keys |= key_bit(record->event.key);
+    stats.held_back++;
+}
+
+/**
+ * Key events
+ * Runs before the tap-hold machinery. A press that cannot start any combo returns true
+ * straight away; only presses of combo keys are held back, and never past the longest
+ * term among the combos they could still complete. Returns false for swallowed events.
+ */
+bool combo_engine_process(uint16_t keycode, keyrecord_t *record) {
+    keypos_t key = record->event.key;
+    if (record->event.type != KEY_EVENT || key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return true;
+    }
+    key_bits_t bit = key_bit(key);
+
+    if (!record->event.pressed) {
+        // any release settles what is held back, so the host still sees events in order
+        if (buffered_keys & bit) {
+            resolve();
+        } else if (buffered) {
+            flush();
+        }
+        for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+            if (combo_held[i] & bit) {
+                // the first key up ends the combo, the rest are swallowed as they follow
+                if (combo_held[i] == combo_keys[i]) {
+                    if (waiting == i) {
+                        // still waiting to go out, it goes out as a tap
+                        waiting_up = true;
+                    } else {
+                        unregister_code16(pgm_read_word(&combo_outputs[i]));
+                    }
+                }
+                combo_held[i] &= ~bit;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    stats.presses++;
+    uint16_t members = active() ? pgm_read_word(&combo_index[key.row][key.col]) & enabled : 0;
+
+    if (buffered) {
+        candidates = live(record->event.time) & members;
+        if (candidates && buffered < COMBO_BUFFER) {
+            hold_back(keycode, record);
+            try_complete(record->event.time);
+            return false;
+        }
+        flush();
+    }
+
+    if (!members) {
+        stats.passed++;
+        note_tapping(keycode, record);
+        return true;
+    }
+
+    uint8_t term = 0;
+    for (uint8_t i = 0; i < COMBO_COUNT; i++) {
+        if ((members & (1 << i)) && pgm_read_byte(&combo_terms[i]) > term) {
+            term = pgm_read_byte(&combo_terms[i]);
+        }
+    }
+    candidates  = members;
+    first_press = record->event.time;
+    hold_back(keycode, record);
+    sched_arm(SCHED_COMBO_TERM, term + 1, term_expired);
+    return false;
+}
+
+// settled events come back here after the core, so an output waiting on them can go out
+void combo_engine_settled(keyrecord_t *record) {
+    if (record->event.type != KEY_EVENT || record->event.key.row >= MATRIX_ROWS || record->event.key.col >= MATRIX_COLS) {
+        return;
+    }
+    tapping &= ~key_bit(record->event.key);
+    if (!tapping) {
+        emit();
+    }
+}
+
+/**
+ * Benchmark
+ * Share of presses that passed straight through, how long held back presses waited before
+ * they fired a combo or were replayed, in total and per settle, and how often a fired combo
+ * waited on an undecided tap-hold key. Per press cycle cost is the pre_process hook in the
+ * profiler (PROFILE_ENABLE).
+ */
+void combo_engine_report(void) {
+    uint32_t seconds = timer_elapsed32(stats.since) / 1000;
+
+    uprintf("combo presses %lu passed %lu held %lu fired %lu (%lu/min)\n", stats.presses, stats.passed, stats.held_back, stats.fired, seconds ? stats.fired * 60 / seconds : 0);
+    uprintf("combo held back ms total %lu max %u mean %lu, outputs behind a tap-hold %lu max %u ms\n", stats.delay_sum, stats.delay_max, stats.settles ? stats.delay_sum / stats.settles : 0,
+            stats.deferred, stats.defer_max);
+}
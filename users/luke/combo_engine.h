@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+#include "map_macro.h"
+
+/**
+ * Combo spec
+ * Keys are named by their LAYER_DFLT keycode, up to three per combo (KC_NO pads), and the
+ * term is how long after the first key the last one may land. Combos only apply while
+ * no layer sits above DFLT.
+ */
+#define COMBO_SPEC(X, k)                                        \
+    X(k, CB_ESC,  KC_ESC, 30, KC_W,  KC_F,    KC_NO)            \
+    X(k, CB_ENT,  KC_ENT, 30, KC_H,  KC_COMM, KC_NO)            \
+    X(k, CB_SCRN, LSG_S,  40, KC_X,  KC_C,    KC_D)
+
+#define COMBO_NAME(k, name, output, term, k1, k2, k3) name,
+enum combo_id { COMBO_SPEC(COMBO_NAME, 0) COMBO_COUNT };
+
+_Static_assert(COMBO_COUNT <= 16, "combo_index entries are 16 bit masks");
+
+// index entry: bit n set when the key is part of combo n
+#define COMBO_MATCH(k, name, output, term, k1, k2, k3) | (((k) != KC_NO && ((k) == (k1) || (k) == (k2) || (k) == (k3))) ? 1 << (name) : 0)
+#define COMBO_ENTRY(k)                                 (0 COMBO_SPEC(COMBO_MATCH, k))
+
+/**
+ * Generates combo_index from a keymap layer macro, like TAP_HOLD_TABLE, so each combo's
+ * keys are found by matrix position on every board without listing positions by hand
+ */
+#define COMBO_INDEX(...) const uint16_t PROGMEM combo_index[MATRIX_ROWS][MATRIX_COLS] = LAYOUT_wrapper(MAP_LIST(COMBO_ENTRY, __VA_ARGS__))
+
+extern const uint16_t PROGMEM combo_index[MATRIX_ROWS][MATRIX_COLS];
+
+// most keys in a combo, so the most presses ever held back at once
+#define COMBO_BUFFER 3
+
+void combo_engine_init(void);
+bool combo_engine_process(uint16_t keycode, keyrecord_t *record);
+void combo_engine_settled(keyrecord_t *record);
+void combo_engine_report(void);
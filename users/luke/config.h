@@ -0,0 +1,16 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// custom split transactions, see split_sync.c and split_probe.c
+#define SPLIT_TRANSACTION_IDS_USER USER_SPLIT_SYNC, USER_SPLIT_PROBE
+
+// settings journal, see settings.c, then the remapped keys, see remap.c
+#define SETTINGS_DATA_SIZE 512
+#ifdef REMAP_ENABLE
+#    define REMAP_DATA_SIZE 512
+#else
+#    define REMAP_DATA_SIZE 0
+#endif
+#define EECONFIG_USER_DATA_SIZE (SETTINGS_DATA_SIZE + REMAP_DATA_SIZE)
+// bumped whenever either layout changes, so QMK hands back a cleared block instead of misreading it
+#define EECONFIG_USER_DATA_VERSION 2
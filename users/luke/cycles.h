@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <stdint.h>
+#include "timer_us.h"
+
+#if defined(PROTOCOL_CHIBIOS)
+#    include "hal.h"
+#endif
+
+/**
+ * Cycle counter
+ * Cortex-M3 and up have DWT->CYCCNT. The RP2040's M0+ has no DWT, but ChibiOS drives its
+ * system tick from the RP2040 timer, which leaves SysTick free to run as a 24 bit down
+ * counter at the core clock. Anything else falls back to microseconds.
+ */
+#if defined(MCU_RP)
+#    define CYCLES_MASK 0xFFFFFF
+
+static inline void cycles_init(void) {
+    SysTick->LOAD = CYCLES_MASK;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+static inline uint32_t cycles_read(void) {
+    return SysTick->VAL;
+}
+
+static inline uint32_t cycles_since(uint32_t start) {
+    return (start - SysTick->VAL) & CYCLES_MASK;
+}
+#elif defined(DWT) && defined(DWT_CTRL_CYCCNTENA_Msk)
+#    define CYCLES_MASK 0xFFFFFFFF
+
+static inline void cycles_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t cycles_read(void) {
+    return DWT->CYCCNT;
+}
+
+static inline uint32_t cycles_since(uint32_t start) {
+    return DWT->CYCCNT - start;
+}
+#else
+#    define CYCLES_MASK 0xFFFFFFFF
+
+static inline void cycles_init(void) {}
+
+static inline uint32_t cycles_read(void) {
+    return timer_read_us();
+}
+
+static inline uint32_t cycles_since(uint32_t start) {
+    return timer_elapsed_us(start);
+}
+#endif
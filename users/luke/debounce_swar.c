@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "matrix.h"
+#include "debounce.h"
+#include "timer.h"
+#include "profile.h"
+
+/**
+ * Asymmetric eager debounce, a row at a time
+ * A press reaches the cooked matrix on the scan it is first seen; a release only once the
+ * key has read open for DEBOUNCE ms without a break, so press chatter never becomes a
+ * release and release chatter is over before the key can be pressed again.
+ *
+ * The release timers are bit-sliced: plane n of a row holds bit n of every key's count
+ * of open milliseconds, so one scan ages, resets and compares a whole row with a handful
+ * of word operations instead of a loop over per-key counters, and the state is
+ * DEBOUNCE_PLANES words per row, plus one for the keys being timed, whatever the number
+ * of columns.
+ */
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+// enough planes to hold 2 * DEBOUNCE, a count plus one scan's worth of elapsed time
+#if DEBOUNCE < 8
+#    define DEBOUNCE_PLANES 4
+#elif DEBOUNCE < 16
+#    define DEBOUNCE_PLANES 5
+#elif DEBOUNCE < 32
+#    define DEBOUNCE_PLANES 6
+#else
+#    define DEBOUNCE_PLANES 8
+#endif
+
+_Static_assert(DEBOUNCE < 128, "DEBOUNCE_PLANES tops out at 8");
+
+static matrix_row_t planes[MATRIX_ROWS][DEBOUNCE_PLANES];
+static matrix_row_t timing[MATRIX_ROWS]; // keys already open on the previous scan
+static uint16_t     last_tick = 0;
+static bool         waiting   = false;
+
+void debounce_init(uint8_t num_rows) {
+    last_tick = timer_read();
+}
+
+void debounce_free(void) {}
+
+// adds the same small constant to every counter selected by mask
+static void planes_add(matrix_row_t *counter, matrix_row_t mask, uint8_t value) {
+    matrix_row_t carry = 0;
+    for (uint8_t n = 0; n < DEBOUNCE_PLANES; n++) {
+        matrix_row_t bit = value >> n & 1 ? mask : 0;
+        matrix_row_t sum = counter[n] ^ bit ^ carry;
+        carry            = (counter[n] & bit) | (carry & (counter[n] ^ bit));
+        counter[n]       = sum;
+    }
+}
+
+// keys whose counter has reached DEBOUNCE, walking the planes from the top bit down
+static matrix_row_t planes_expired(const matrix_row_t *counter) {
+    matrix_row_t above = 0;
+    matrix_row_t equal = (matrix_row_t)~0;
+    for (uint8_t n = DEBOUNCE_PLANES; n--;) {
+        if (DEBOUNCE >> n & 1) {
+            equal &= counter[n];
+        } else {
+            above |= equal & counter[n];
+            equal &= ~counter[n];
+        }
+    }
+    return above | equal;
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    // nothing new and no release timing, the cooked matrix already matches
+    if (!changed && !waiting) {
+        return false;
+    }
+    PROFILE_BEGIN(PROF_DEBOUNCE);
+
+    // time only counts while a release is being timed, not the idle stretch before it
+    uint16_t now     = timer_read();
+    uint16_t elapsed = waiting ? TIMER_DIFF_16(now, last_tick) : 0;
+    uint8_t  ticks   = elapsed < DEBOUNCE ? elapsed : DEBOUNCE;
+    // a scan with no change in the same millisecond as the last has nothing to age
+    if (!changed && !ticks) {
+        PROFILE_END(PROF_DEBOUNCE);
+        return false;
+    }
+    last_tick = now;
+
+    bool cooked_changed = false;
+    waiting             = false;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        matrix_row_t *counter = planes[row];
+        matrix_row_t  pressed = raw[row] & ~cooked[row];
+        matrix_row_t  open    = cooked[row] & ~raw[row];
+
+        // nothing open now or on the last scan, the planes are clear already
+        if (!(open | timing[row])) {
+            if (pressed) {
+                cooked[row] |= pressed;
+                cooked_changed = true;
+            }
+            continue;
+        }
+
+        // a key that reads closed again, or is not down, starts its next release from zero
+        for (uint8_t n = 0; n < DEBOUNCE_PLANES; n++) {
+            counter[n] &= open;
+        }
+        // a key first seen open now starts at zero, the time since the last scan
+        // belongs to keys that were already open then
+        matrix_row_t aging = open & timing[row];
+        if (aging && ticks) {
+            planes_add(counter, aging, ticks);
+        }
+
+        matrix_row_t released = open & planes_expired(counter);
+        for (uint8_t n = 0; n < DEBOUNCE_PLANES; n++) {
+            counter[n] &= ~released;
+        }
+
+        if (pressed | released) {
+            cooked[row]    = (cooked[row] | pressed) & ~released;
+            cooked_changed = true;
+        }
+        timing[row] = open & ~released;
+        waiting |= timing[row] != 0;
+    }
+
+    PROFILE_END(PROF_DEBOUNCE);
+    return cooked_changed;
+}
@@ -0,0 +1,377 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "fuzz.h"
+#include <string.h>
+#include "host.h"
+#include "print.h"
+#include "timer_us.h"
+
+_Static_assert(MATRIX_ROWS <= 16 && MATRIX_COLS <= 16, "events pack the position into a byte");
+_Static_assert(FUZZ_MAX_EVENTS <= UINT8_MAX, "event indexes are one byte");
+_Static_assert(5 + MATRIX_ROWS * 2 <= RAW_EPSIZE, "the info reply carries a 16 bit mask per row");
+
+typedef struct __attribute__((packed)) {
+    uint16_t delay;    // milliseconds after the previous event, 0 for the same scan
+    uint8_t  position; // row << 4 | col
+    uint8_t  pressed;
+} fuzz_event_t;
+
+// events per RAW_FUZZ_LOAD report, after the command, status, index and count bytes
+#define FUZZ_EVENTS_PER_LOAD ((RAW_EPSIZE - 4) / sizeof(fuzz_event_t))
+
+/**
+ * Stream replay
+ * tools/fuzz.py generates the seeded press/release streams, uploads them and shrinks the
+ * ones that fail; the board presses and releases each key in the matrix at the pace it
+ * was written, so the core makes the key events itself and the combo engine, tap-hold
+ * machinery, layers, every userspace hook and everything that reads the matrix see the
+ * stream exactly as they would see typing. Only the keyboard reports are held back from
+ * the host while a stream runs, and keycodes that would reach past the keyboard
+ * (bootloader, settings, macros, media, mouse) are swallowed.
+ */
+static fuzz_event_t events[FUZZ_MAX_EVENTS];
+static uint8_t      count = 0;
+static uint8_t      next  = 0;
+static uint8_t      state = FUZZ_IDLE;
+static uint16_t     last  = 0;
+
+// the scan that carried the stream's last changes, timed until housekeeping
+static uint32_t scan_start = 0;
+static bool     scan_busy  = false;
+
+// what the stream holds down, and the tap-hold presses that have not settled yet
+static matrix_row_t held[MATRIX_ROWS];
+static matrix_row_t tracked[MATRIX_ROWS];
+static uint8_t      pending[MATRIX_ROWS][MATRIX_COLS];
+static uint8_t      expected_layer = DFLT;
+static bool         host_keys      = false;
+
+static struct {
+    uint8_t       failures;
+    uint8_t       mods;
+    layer_state_t layers;
+    uint16_t      events;
+    uint16_t      presses; // put in the matrix
+    uint16_t      seen;    // reached pre_process
+    uint32_t      busy_us; // the scans that carried the stream, see fuzz_task
+    uint32_t      max_us;
+    uint32_t      start;
+    uint32_t      elapsed_ms;
+} run;
+
+static struct {
+    uint32_t streams;
+    uint32_t failed;
+    uint32_t events;
+    uint32_t busy_us;
+    uint32_t max_us;
+} totals;
+
+bool fuzz_running(void) {
+    return state == FUZZ_RUNNING || state == FUZZ_SETTLING;
+}
+
+/**
+ * Outcomes
+ * A tap-hold press is counted when it enters pre_process and again when the core hands
+ * it to process_record as a tap or a hold, under whatever keycode the layers give it
+ * by then. Each side runs first in its hook, so a later hook swallowing the key still
+ * counts. Every press is counted in pre_process too: one the stream put in the matrix
+ * that never shows up there means the core did not read the rows through the wrap.
+ */
+void fuzz_event(uint16_t keycode, keyrecord_t *record) {
+    keypos_t key = record->event.key;
+    if (!fuzz_running() || !record->event.pressed || record->event.type != KEY_EVENT || key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return;
+    }
+    run.seen++;
+    if (fuzz_tap_hold(keycode)) {
+        pending[key.row][key.col]++;
+        tracked[key.row] |= (matrix_row_t)1 << key.col;
+    }
+}
+
+bool fuzz_process(uint16_t keycode, keyrecord_t *record) {
+    if (!fuzz_running()) {
+        return true;
+    }
+
+    keypos_t key = record->event.key;
+    if (record->event.pressed && key.row < MATRIX_ROWS && key.col < MATRIX_COLS && (tracked[key.row] >> key.col & 1)) {
+        if (pending[key.row][key.col]) {
+            pending[key.row][key.col]--;
+        } else if (fuzz_tap_hold(keycode)) {
+            run.failures |= FUZZ_EXTRA_OUTCOME;
+        }
+    }
+    if (record->event.pressed && IS_QK_TO(keycode)) {
+        expected_layer = QK_TO_GET_LAYER(keycode);
+    }
+    return fuzz_allowed(keycode);
+}
+
+/**
+ * Host reports
+ * Held back while a stream runs; the last one is what the host would be left with, so
+ * anything still in it at the end is a stuck key
+ */
+static bool report_empty(const uint8_t *bytes, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) {
+        if (bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void __real_host_keyboard_send(report_keyboard_t *report);
+
+void __wrap_host_keyboard_send(report_keyboard_t *report) {
+    if (!fuzz_running()) {
+        __real_host_keyboard_send(report);
+        return;
+    }
+    host_keys = report->mods || !report_empty(report->keys, sizeof(report->keys));
+}
+
+#ifdef NKRO_ENABLE
+void __real_host_nkro_send(report_nkro_t *report);
+
+void __wrap_host_nkro_send(report_nkro_t *report) {
+    if (!fuzz_running()) {
+        __real_host_nkro_send(report);
+        return;
+    }
+    host_keys = report->mods || !report_empty(report->bits, sizeof(report->bits));
+}
+#endif
+
+/**
+ * Matrix
+ * The stream's keys are ORed into the debounced rows every reader gets, the core's scan
+ * included, so the core turns them into key events and activity on the scan they land
+ * in, and the governor and speculative taps see them held like real keys. --wrap only
+ * redirects calls between objects, which LTO may have folded together, so each stream
+ * checks that its presses came out as key events, see FUZZ_UNSEEN_PRESS.
+ */
+matrix_row_t __real_matrix_get_row(uint8_t row);
+
+matrix_row_t __wrap_matrix_get_row(uint8_t row) {
+    return __real_matrix_get_row(row) | (row < MATRIX_ROWS ? held[row] : 0);
+}
+
+static void inject(uint8_t row, uint8_t col, bool pressed) {
+    matrix_row_t bit = (matrix_row_t)1 << col;
+    if (row >= MATRIX_ROWS || col >= MATRIX_COLS || !(held[row] & bit) != pressed) {
+        run.failures |= FUZZ_BAD_STREAM;
+        return;
+    }
+    held[row] ^= bit;
+    run.events++;
+    run.presses += pressed;
+}
+
+static void start(uint8_t length) {
+    layer_clear();
+    clear_keyboard();
+    memset(held, 0, sizeof(held));
+    memset(tracked, 0, sizeof(tracked));
+    memset(pending, 0, sizeof(pending));
+    memset(&run, 0, sizeof(run));
+    expected_layer = DFLT;
+    host_keys      = false;
+
+    count     = length;
+    next      = 0;
+    last      = timer_read();
+    run.start = timer_read32();
+    state     = FUZZ_RUNNING;
+}
+
+static void check(void) {
+    run.mods   = get_mods() | get_weak_mods() | get_oneshot_mods();
+    run.layers = layer_state;
+    if (run.mods) {
+        run.failures |= FUZZ_STUCK_MODS;
+    }
+    if (host_keys) {
+        run.failures |= FUZZ_STUCK_KEYS;
+    }
+    if (run.seen < run.presses) {
+        run.failures |= FUZZ_UNSEEN_PRESS;
+    }
+    // TO(DFLT) leaves DFLT's own bit on, nothing else may be
+    layer_state_t want = (layer_state_t)1 << expected_layer;
+    if (run.layers != want && !(expected_layer == DFLT && run.layers == 0)) {
+        run.failures |= FUZZ_STUCK_LAYER;
+    }
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (pending[row][col]) {
+                run.failures |= FUZZ_LOST_OUTCOME;
+            }
+        }
+    }
+
+    totals.streams++;
+    totals.failed += run.failures != 0;
+    totals.events += run.events;
+    totals.busy_us += run.busy_us;
+    if (run.max_us > totals.max_us) {
+        totals.max_us = run.max_us;
+    }
+}
+
+/**
+ * Pacing
+ * Called from matrix_scan_user every scan, after debounce and before the core reads the
+ * rows. Events due together land in the same scan, the way a rollover does, and the
+ * schedule is kept from the stream's start, so a slow scan is caught up rather than
+ * stretching the rest of the stream.
+ */
+void fuzz_scan(void) {
+    if (state != FUZZ_RUNNING) {
+        return;
+    }
+
+    // a key changes at most once a scan, as in a real matrix: a second change of the same
+    // key waits for the next scan instead of cancelling the first unseen
+    matrix_row_t moved[MATRIX_ROWS] = {0};
+    uint16_t     before             = run.events;
+    while (next < count && timer_elapsed(last) >= events[next].delay) {
+        uint8_t row = events[next].position >> 4;
+        uint8_t col = events[next].position & 0xF;
+        if (row < MATRIX_ROWS && (moved[row] >> col & 1)) {
+            break;
+        }
+        if (row < MATRIX_ROWS) {
+            moved[row] |= (matrix_row_t)1 << col;
+        }
+        last += events[next].delay;
+        inject(row, col, events[next].pressed);
+        next++;
+    }
+    if (next >= count) {
+        run.elapsed_ms = timer_elapsed32(run.start);
+        // a stream that ends with keys down is malformed, let go of them before settling
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; held[row]; col++) {
+                if (held[row] >> col & 1) {
+                    inject(row, col, false);
+                    run.failures |= FUZZ_BAD_STREAM;
+                }
+            }
+        }
+        last  = timer_read();
+        state = FUZZ_SETTLING;
+    }
+
+    if (run.events != before) {
+        scan_start = timer_read_us();
+        scan_busy  = true;
+    }
+}
+
+/**
+ * Processing time
+ * From the stream's keys landing in the matrix to housekeeping at the end of the same
+ * keyboard task: the key events they made and whatever else ran in that pass, so the
+ * figure per event is an upper bound
+ */
+void fuzz_task(void) {
+    if (scan_busy) {
+        uint32_t took = timer_elapsed_us(scan_start);
+        run.busy_us += took;
+        if (took > run.max_us) {
+            run.max_us = took;
+        }
+        scan_busy = false;
+    }
+
+    if (state == FUZZ_SETTLING && timer_elapsed(last) >= FUZZ_SETTLE_MS) {
+        check();
+        state = FUZZ_DONE;
+        // hand the keyboard back clean whatever the stream left behind
+        layer_clear();
+        clear_keyboard();
+    }
+}
+
+static void put32(uint8_t *data, uint32_t value) {
+    for (uint8_t i = 0; i < 4; i++) {
+        data[i] = value >> (i * 8);
+    }
+}
+
+/**
+ * Raw hid
+ * Byte 1 carries the status in replies, requests leave it 0:
+ * RAW_FUZZ_INFO   -> rows, cols, max events, then a little endian mask per row of the
+ *                    keys that are tap-hold, mod or layer keys on some layer
+ * RAW_FUZZ_LOAD   first index, count, then up to 7 events of delay (little endian),
+ *                 position and pressed
+ * RAW_FUZZ_RUN    event count, starts the stream on the next scan
+ * RAW_FUZZ_STATUS -> state, failures, mods and layer state at the check, events,
+ *                    busy us, max us, stream ms
+ */
+void fuzz_raw(uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+        case RAW_FUZZ_INFO:
+            data[1] = FUZZ_OK;
+            data[2] = MATRIX_ROWS;
+            data[3] = MATRIX_COLS;
+            data[4] = FUZZ_MAX_EVENTS;
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                uint16_t mask = 0;
+                for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                    for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+                        if (fuzz_special(keycode_at_keymap_location(layer, row, col))) {
+                            mask |= 1 << col;
+                        }
+                    }
+                }
+                data[5 + row * 2] = mask & 0xFF;
+                data[6 + row * 2] = mask >> 8;
+            }
+            break;
+        case RAW_FUZZ_LOAD: {
+            uint8_t index = data[2];
+            uint8_t n     = data[3];
+            if (fuzz_running()) {
+                data[1] = FUZZ_BUSY;
+            } else if (n > FUZZ_EVENTS_PER_LOAD || index + n > FUZZ_MAX_EVENTS) {
+                data[1] = FUZZ_TOO_LONG;
+            } else {
+                memcpy(&events[index], &data[4], n * sizeof(fuzz_event_t));
+                data[1] = FUZZ_OK;
+            }
+            break;
+        }
+        case RAW_FUZZ_RUN:
+            if (fuzz_running()) {
+                data[1] = FUZZ_BUSY;
+            } else if (data[2] > FUZZ_MAX_EVENTS) {
+                data[1] = FUZZ_TOO_LONG;
+            } else {
+                start(data[2]);
+                data[1] = FUZZ_OK;
+            }
+            break;
+        case RAW_FUZZ_STATUS:
+            data[1] = FUZZ_OK;
+            data[2] = state;
+            data[3] = run.failures;
+            data[4] = run.mods;
+            put32(&data[5], run.layers);
+            data[9]  = run.events & 0xFF;
+            data[10] = run.events >> 8;
+            put32(&data[11], run.busy_us);
+            put32(&data[15], run.max_us);
+            put32(&data[19], run.elapsed_ms);
+            break;
+    }
+}
+
+void fuzz_report(void) {
+    uint32_t busy = totals.busy_us ? totals.busy_us : 1;
+    uprintf("fuzz: %lu streams (%lu failed), %lu events, %lu us/event avg, %lu us max, %lu events/s capacity\n", totals.streams, totals.failed, totals.events, totals.events ? totals.busy_us / totals.events : 0, totals.max_us, (uint32_t)((uint64_t)totals.events * 1000000 / busy));
+}
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+#include "tap_hold.h"
+
+// events one stream may hold, tools/fuzz.py keeps its streams within this
+#ifndef FUZZ_MAX_EVENTS
+#    define FUZZ_MAX_EVENTS 192
+#endif
+
+// quiet time after the last release before the invariants are checked, long enough for
+// every tap-hold key, combo and deferred release to have settled
+#ifndef FUZZ_SETTLE_MS
+#    define FUZZ_SETTLE_MS (HRM_TAPPING_TERM + 300)
+#endif
+
+// status byte of every fuzz reply, see tools/fuzz.py
+enum fuzz_status {
+    FUZZ_OK,
+    FUZZ_BUSY,
+    FUZZ_TOO_LONG,
+};
+
+enum fuzz_state {
+    FUZZ_IDLE,
+    FUZZ_RUNNING,
+    FUZZ_SETTLING,
+    FUZZ_DONE,
+};
+
+// invariants a stream broke, reported as a mask
+enum fuzz_failure {
+    FUZZ_STUCK_MODS    = 1 << 0, // mods left on, real, weak or oneshot
+    FUZZ_STUCK_KEYS    = 1 << 1, // the last report the host would have seen is not empty
+    FUZZ_STUCK_LAYER   = 1 << 2, // layers other than the one the last TO() asked for
+    FUZZ_LOST_OUTCOME  = 1 << 3, // a tap-hold press that never settled as a tap or hold
+    FUZZ_EXTRA_OUTCOME = 1 << 4, // a tap-hold press that settled more than once
+    FUZZ_BAD_STREAM    = 1 << 5, // presses of held keys or releases of keys that are up
+    FUZZ_UNSEEN_PRESS  = 1 << 6, // a press the core never turned into a key event
+};
+
+/**
+ * Keycodes
+ * Shared by the board's stream replay and tests/fuzz, so both fuzz the same keys
+ */
+static inline bool fuzz_tap_hold(uint16_t keycode) {
+    return IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode);
+}
+
+// drawn from more often: the keys that change what the others do
+static inline bool fuzz_special(uint16_t keycode) {
+    return fuzz_tap_hold(keycode) || IS_MODIFIER_KEYCODE(keycode) || IS_QK_MODS(keycode) || IS_QK_MOMENTARY(keycode) || IS_QK_TO(keycode);
+}
+
+// what a stream may type: keys, mods and layer changes, nothing that leaves the keyboard
+static inline bool fuzz_allowed(uint16_t keycode) {
+    return keycode <= KC_TRNS || IS_BASIC_KEYCODE(keycode) || IS_MODIFIER_KEYCODE(keycode) || IS_QK_MODS(keycode) || fuzz_tap_hold(keycode) || IS_QK_MOMENTARY(keycode) || IS_QK_TO(keycode) || keycode == QK_GESC;
+}
+
+#ifdef FUZZ_ENABLE
+bool fuzz_running(void);
+void fuzz_event(uint16_t keycode, keyrecord_t *record);
+bool fuzz_process(uint16_t keycode, keyrecord_t *record);
+void fuzz_scan(void);
+void fuzz_task(void);
+void fuzz_raw(uint8_t *data, uint8_t length);
+void fuzz_report(void);
+#else
+static inline bool fuzz_running(void) {
+    return false;
+}
+#endif
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "game_mode.h"
+
+static bool active = false;
+
+bool game_mode_is_active(void) {
+    return active;
+}
+
+/**
+ * Profile switch
+ * Follows the GAME bit rather than the highest layer, so holding MO(NAV) or NUM_ENT while
+ * gaming stays in the game profile
+ */
+layer_state_t game_mode_layer_state(layer_state_t state) {
+    active = state & ((layer_state_t)1 << GAME);
+    return state;
+}
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// tapping term for tap-hold keys reachable from GAME, no adaptive or HRM offset; 0 makes
+// them holds on press, so GAME shadows every one with its tap key (HRM letters, Esc,
+// Quote, Enter, Space) and reaches SYS through a plain MO(SYS)
+#ifndef GAME_TAPPING_TERM
+#    define GAME_TAPPING_TERM 0
+#endif
+
+/**
+ * Runtime profile
+ * Typing is the default profile; GAME takes over while the GAME layer is on and hands
+ * back untouched when it goes off again, since nothing the typing profile owns is changed
+ */
+enum game_profile {
+    PROFILE_TYPING,
+    PROFILE_GAME,
+    PROFILE_COUNT
+};
+
+bool          game_mode_is_active(void);
+layer_state_t game_mode_layer_state(layer_state_t state);
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "governor.h"
+#include "print.h"
+#include "sched.h"
+#include "timer.h"
+#include "wait.h"
+#ifdef MACRO_SENDER_ENABLE
+#    include "macro_sender.h"
+#endif
+
+_Static_assert(GOVERNOR_IDLE_MS < GOVERNOR_DEEP_MS, "idle comes before deep idle");
+_Static_assert(GOVERNOR_IDLE_PERIOD_MS <= GOVERNOR_DEEP_PERIOD_MS, "deep idle scans no faster than idle");
+
+static const char *const state_names[GOV_STATE_COUNT] = {
+    [GOV_ACTIVE] = "active",
+    [GOV_IDLE]   = "idle",
+    [GOV_DEEP]   = "deep",
+};
+
+static uint8_t       state        = GOV_ACTIVE;
+static uint8_t       master_floor = GOV_DEEP; // slave only, the master's state from split sync
+static volatile bool woken        = false;
+static uint32_t      state_timer  = 0;
+
+static struct {
+    uint32_t ms[GOV_STATE_COUNT];
+    uint32_t loops[GOV_STATE_COUNT];
+    uint32_t slept_ms;
+    uint32_t wakes;
+} stats;
+
+// a held key is a layer, a hold or a mouse button in use, the user is still there
+static bool keys_down(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        if (matrix_get_row(row)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t target_state(void) {
+#ifdef MACRO_SENDER_ENABLE
+    if (macro_sender_busy()) {
+        return GOV_ACTIVE;
+    }
+#endif
+    if (keys_down()) {
+        return GOV_ACTIVE;
+    }
+
+    // the same comparison rgb_gate.c makes, so deep idle starts with the LEDs going dark
+    uint32_t quiet  = last_input_activity_elapsed();
+    uint8_t  target = quiet > GOVERNOR_DEEP_MS ? GOV_DEEP : quiet > GOVERNOR_IDLE_MS ? GOV_IDLE : GOV_ACTIVE;
+
+    // the slave only sees its own keys, so it never sleeps deeper than the master
+    if (!is_keyboard_master() && master_floor < target) {
+        target = master_floor;
+    }
+    return target;
+}
+
+static void account(void) {
+    uint32_t now = timer_read32();
+    stats.ms[state] += TIMER_DIFF_32(now, state_timer);
+    state_timer = now;
+}
+
+static void enter(uint8_t next) {
+    account();
+    if (next == GOV_ACTIVE) {
+        stats.wakes++;
+    }
+    state = next;
+}
+
+/**
+ * Governor
+ * Runs last in housekeeping and sleeps the rest of the loop pass away when nothing has
+ * happened for a while, so the matrix scan and every housekeeping task slow down together.
+ * The state is worked out afresh each pass from the core's activity timer, which the scan
+ * that sees a change has already reset, so that pass runs at full rate with the key in it.
+ * Sleeps never run past the next scheduler deadline, which keeps the deferred settings
+ * flush after a brightness change on time, and are cut short when the master wakes up.
+ */
+void governor_task(void) {
+    woken          = false;
+    uint8_t target = target_state();
+    if (target != state) {
+        enter(target);
+    }
+    stats.loops[state]++;
+    if (state == GOV_ACTIVE) {
+        return;
+    }
+
+    uint32_t period = state == GOV_DEEP ? GOVERNOR_DEEP_PERIOD_MS : GOVERNOR_IDLE_PERIOD_MS;
+    uint32_t due    = sched_due_in();
+    if (due < period) {
+        period = due;
+    }
+    for (; period && !woken; period--) {
+        wait_ms(1);
+        stats.slept_ms++;
+    }
+}
+
+uint8_t governor_state(void) {
+    return state;
+}
+
+// slave side, called from the split sync handler
+void governor_sync(uint8_t master_state) {
+    if (master_state >= GOV_STATE_COUNT) {
+        return;
+    }
+    if (master_state < state) {
+        woken = true;
+    }
+    master_floor = master_state;
+}
+
+void governor_report(void) {
+    account();
+    uprintf("governor %s, %lu wakes, slept %lu ms\n", state_names[state], stats.wakes, stats.slept_ms);
+    for (uint8_t i = 0; i < GOV_STATE_COUNT; i++) {
+        uprintf("  %s %lu s, %lu loops\n", state_names[i], stats.ms[i] / 1000, stats.loops[i]);
+    }
+}
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// no input for this long drops the scan rate to idle
+#ifndef GOVERNOR_IDLE_MS
+#    define GOVERNOR_IDLE_MS 5000
+#endif
+
+// and for this long to deep idle, by default on the same edge that puts the LEDs to sleep
+#ifndef GOVERNOR_DEEP_MS
+#    if defined(RGB_MATRIX_TIMEOUT) && RGB_MATRIX_TIMEOUT > 0
+#        define GOVERNOR_DEEP_MS RGB_MATRIX_TIMEOUT
+#    else
+#        define GOVERNOR_DEEP_MS 60000
+#    endif
+#endif
+
+// milliseconds slept per pass of the main loop, which is also the longest a press can
+// wait for the scan that sees it
+#ifndef GOVERNOR_IDLE_PERIOD_MS
+#    define GOVERNOR_IDLE_PERIOD_MS 1
+#endif
+#ifndef GOVERNOR_DEEP_PERIOD_MS
+#    define GOVERNOR_DEEP_PERIOD_MS 4
+#endif
+
+enum governor_state {
+    GOV_ACTIVE,
+    GOV_IDLE,
+    GOV_DEEP,
+    GOV_STATE_COUNT
+};
+
+void    governor_task(void);
+uint8_t governor_state(void);
+void    governor_sync(uint8_t master_state);
+void    governor_report(void);
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "indicator.h"
+#include "layer_index.h"
+#include "rgb_gate.h"
+#include "sched.h"
+#include "settings.h"
+
+// default hue and saturation per layer, overridable through SETTING_LAYER_COLOR
+static const uint8_t PROGMEM layer_colors[][2] = {
+    [DFLT] = {WHITE},
+    [GAME] = {RED},
+    [NAV]  = {BLUE},
+    [SYS]  = {GREEN},
+    [NUM]  = {PURPLE},
+};
+
+#define INDICATOR_LAYERS ARRAY_SIZE(layer_colors)
+
+#define LED_WORDS ((RGB_MATRIX_LED_COUNT + 31) / 32)
+
+static hsv_t    frames[INDICATOR_LAYERS];
+static uint32_t key_leds[INDICATOR_LAYERS][LED_WORDS]; // LEDs under keys the layer defines
+static rgb_t    key_color;
+static uint8_t  shown_layer   = DFLT;
+static uint8_t  pending_layer = DFLT;
+
+static inline bool highlights(uint8_t layer) {
+    return INDICATOR_HIGHLIGHT_LAYERS & (1 << layer);
+}
+
+/**
+ * Show a layer
+ * Only touches the rgb matrix when the mode or color really differs, since every write
+ * also restarts the effect and gets mirrored to the other half, and any change marks the
+ * frame dirty for rgb_gate.c
+ */
+static void show(uint8_t layer) {
+    hsv_t want = frames[layer];
+    hsv_t have = rgb_matrix_get_hsv();
+
+    // highlighted layers draw a dim base, indicator_render lights the bound keys on top
+    if (highlights(layer)) {
+        want.v >>= INDICATOR_DIM_SHIFT;
+    }
+    if (layer != shown_layer) {
+        rgb_gate_touch();
+    }
+    key_color = hsv_to_rgb(frames[layer]);
+
+    if (rgb_matrix_get_mode() != RGB_MATRIX_SOLID_COLOR) {
+        rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_COLOR);
+        rgb_gate_touch();
+    }
+    if (want.h != have.h || want.s != have.s || want.v != have.v) {
+        rgb_matrix_sethsv_noeeprom(want.h, want.s, want.v);
+        rgb_gate_touch();
+    }
+    shown_layer = layer;
+}
+
+static uint32_t show_pending(void) {
+    show(pending_layer);
+    return 0;
+}
+
+void indicator_set_brightness(uint8_t val) {
+    for (uint8_t i = 0; i < INDICATOR_LAYERS; i++) {
+        uint16_t color = settings_get_or(SETTING_LAYER_COLOR + i, pgm_read_byte(&layer_colors[i][0]) << 8 | pgm_read_byte(&layer_colors[i][1]));
+        frames[i].h    = color >> 8;
+        frames[i].s    = color & 0xFF;
+        frames[i].v    = val;
+    }
+    show(shown_layer);
+}
+
+/**
+ * Key masks
+ * One bit per LED, from the layer index and the board's LED layout, so both boards get
+ * their own without listing LEDs anywhere. Needs layer_index_init first.
+ */
+static void build_key_leds(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint8_t led = g_led_config.matrix_co[row][col];
+            if (led == NO_LED || led >= RGB_MATRIX_LED_COUNT) {
+                continue;
+            }
+            uint8_t layers = layer_index_layers(row, col);
+            for (uint8_t layer = 0; layer < INDICATOR_LAYERS; layer++) {
+                if (layers & (1 << layer)) {
+                    key_leds[layer][led / 32] |= (uint32_t)1 << (led % 32);
+                }
+            }
+        }
+    }
+}
+
+void indicator_init(void) {
+    build_key_leds();
+
+    // the first frame has to be drawn even when eeprom already holds the same color
+    rgb_gate_touch();
+    indicator_set_brightness(settings_get_or(SETTING_BRIGHTNESS, rgb_matrix_get_val()));
+}
+
+/**
+ * Layer changes
+ * Dropping back to a lower layer shows at once. Going up waits INDICATOR_SETTLE_MS, so
+ * the layer flicker from tapping NAV_SPC, NAV_BS or NUM_ENT never reaches the LEDs.
+ */
+layer_state_t indicator_layer_state(layer_state_t state) {
+    uint8_t layer = get_highest_layer(state);
+    if (layer >= INDICATOR_LAYERS) {
+        layer = DFLT;
+    }
+
+    if (layer <= shown_layer) {
+        sched_cancel(SCHED_INDICATOR_SETTLE);
+        show(layer);
+    } else if (!sched_is_armed(SCHED_INDICATOR_SETTLE) || pending_layer != layer) {
+        pending_layer = layer;
+        sched_arm(SCHED_INDICATOR_SETTLE, INDICATOR_SETTLE_MS, show_pending);
+    }
+
+    return state;
+}
+
+uint8_t indicator_layer(void) {
+    return shown_layer;
+}
+
+uint8_t indicator_brightness(void) {
+    return frames[DFLT].v;
+}
+
+/**
+ * Key highlights
+ * Called for each chunk of the frame; walks the set bits of the shown layer's mask within
+ * [led_min, led_max), a few word operations per chunk
+ */
+void indicator_render(uint8_t led_min, uint8_t led_max) {
+    if (!highlights(shown_layer)) {
+        return;
+    }
+
+    const uint32_t *mask = key_leds[shown_layer];
+    for (uint8_t word = led_min / 32; word < LED_WORDS && word * 32 < led_max; word++) {
+        uint32_t bits = mask[word];
+        while (bits) {
+            uint8_t led = word * 32 + __builtin_ctz(bits);
+            bits &= bits - 1;
+            if (led >= led_min && led < led_max) {
+                rgb_matrix_set_color(led, key_color.r, key_color.g, key_color.b);
+            }
+        }
+    }
+}
+
+// applies what the master half is showing, see split_sync.c
+void indicator_sync(uint8_t layer, uint8_t val) {
+    if (layer >= INDICATOR_LAYERS) {
+        return;
+    }
+
+    if (frames[layer].v != val) {
+        indicator_set_brightness(val);
+    }
+    show(layer);
+}
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// how long a higher layer has to stay active before it is shown
+#ifndef INDICATOR_SETTLE_MS
+#    define INDICATOR_SETTLE_MS TAPPING_TERM
+#endif
+
+// held layers that light only their bound keys over a dim base
+#ifndef INDICATOR_HIGHLIGHT_LAYERS
+#    define INDICATOR_HIGHLIGHT_LAYERS ((1 << NAV) | (1 << SYS) | (1 << NUM))
+#endif
+
+// base brightness on highlighted layers, as a right shift of the full brightness
+#ifndef INDICATOR_DIM_SHIFT
+#    define INDICATOR_DIM_SHIFT 3
+#endif
+
+void          indicator_init(void);
+void          indicator_set_brightness(uint8_t val);
+layer_state_t indicator_layer_state(layer_state_t state);
+uint8_t       indicator_layer(void);
+uint8_t       indicator_brightness(void);
+void          indicator_render(uint8_t led_min, uint8_t led_max);
+void          indicator_sync(uint8_t layer, uint8_t val);
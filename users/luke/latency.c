@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "latency.h"
+#include <string.h>
+#include "tap_hold.h"
+#include "game_mode.h"
+#include "print.h"
+#include "timer.h"
+
+// one set per runtime profile, so typing and GAME can be compared side by side
+static latency_hist_t hists[PROFILE_COUNT][LAT_CLASS_COUNT];
+
+const char *const latency_class_names[LAT_CLASS_COUNT] = {
+    [LAT_HRM]      = "hrm",
+    [LAT_THUMB]    = "thumb",
+    [LAT_TAP_HOLD] = "tap-hold",
+    [LAT_PLAIN]    = "plain",
+};
+
+static const char *const profile_names[PROFILE_COUNT] = {
+    [PROFILE_TYPING] = "typing",
+    [PROFILE_GAME]   = "game",
+};
+
+uint8_t latency_class(uint16_t keycode, keyrecord_t *record) {
+    if (tap_hold_flags(keycode, record) & TH_HRM_TERM) {
+        return LAT_HRM;
+    }
+    if (keycode == NAV_SPC || keycode == NAV_BS) {
+        return LAT_THUMB;
+    }
+    if (IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode)) {
+        return LAT_TAP_HOLD;
+    }
+    return LAT_PLAIN;
+}
+
+/**
+ * Trace capture
+ * With LATENCY_TRACE every physical press and release goes out over the console as it
+ * reaches the action layer, in the trace format tests/latency replays through the core;
+ * tools/traces.py turns a console capture into a trace file. Off by default, it logs
+ * everything typed.
+ */
+void latency_event(keyrecord_t *record) {
+#ifdef LATENCY_TRACE
+    keypos_t key = record->event.key;
+    if (record->event.type != KEY_EVENT || key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return;
+    }
+    uprintf("trace %u %u %c\n", record->event.time, pgm_read_byte(&key_index[key.row][key.col]), record->event.pressed ? 'd' : 'u');
+#endif
+}
+
+/**
+ * Press-to-report latency
+ * post_process_record runs right after the action has been sent to the host, while
+ * event.time still holds the physical press time, so the difference is exactly the delay
+ * the tap-hold pipeline added. Taps settled on release are counted when they resolve.
+ */
+void latency_record(uint16_t keycode, keyrecord_t *record) {
+    if (!record->event.pressed || record->event.type != KEY_EVENT) {
+        return;
+    }
+
+    latency_hist_t *hist    = &hists[game_mode_is_active() ? PROFILE_GAME : PROFILE_TYPING][latency_class(keycode, record)];
+    uint16_t        elapsed = timer_elapsed(record->event.time);
+    uint16_t        bucket  = elapsed / LATENCY_BUCKET_MS;
+
+    if (bucket >= LATENCY_BUCKETS) {
+        bucket = LATENCY_BUCKETS - 1;
+    }
+    if (hist->buckets[bucket] < UINT16_MAX) {
+        hist->buckets[bucket]++;
+    }
+    if (hist->count < UINT16_MAX) {
+        hist->count++;
+    }
+    if (elapsed > hist->max) {
+        hist->max = elapsed;
+    }
+}
+
+const latency_hist_t *latency_hist(uint8_t profile, uint8_t which) {
+    return &hists[profile][which];
+}
+
+// upper edge of the bucket holding the given percentile, 0 when empty
+uint16_t latency_percentile(const latency_hist_t *hist, uint8_t percent) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+        total += hist->buckets[i];
+    }
+    if (!total) {
+        return 0;
+    }
+
+    uint32_t target = (total * percent + 99) / 100;
+    uint32_t seen   = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= target) {
+            return (i + 1) * LATENCY_BUCKET_MS;
+        }
+    }
+    return hist->max;
+}
+
+void latency_reset(void) {
+    memset(hists, 0, sizeof(hists));
+}
+
+void latency_report(void) {
+    uprintf("latency ms (tapping term %u, game term %u, flow tap term %u)\n", TAPPING_TERM, GAME_TAPPING_TERM, FLOW_TAP_TERM);
+    for (uint8_t p = 0; p < PROFILE_COUNT; p++) {
+        for (uint8_t i = 0; i < LAT_CLASS_COUNT; i++) {
+            const latency_hist_t *hist = &hists[p][i];
+            uprintf("%-6s %-8s n=%5u p50=%3u p99=%3u max=%3u\n", profile_names[p], latency_class_names[i], hist->count, latency_percentile(hist, 50), latency_percentile(hist, 99), hist->max);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// histogram resolution and range: 128 buckets of 4 ms covers 0-511 ms
+#ifndef LATENCY_BUCKET_MS
+#    define LATENCY_BUCKET_MS 4
+#endif
+#define LATENCY_BUCKETS 128
+
+enum latency_class {
+    LAT_HRM,      // HRM_* home row mods
+    LAT_THUMB,    // NAV_SPC / NAV_BS layer taps
+    LAT_TAP_HOLD, // every other mod tap or layer tap
+    LAT_PLAIN,    // everything else
+    LAT_CLASS_COUNT
+};
+
+typedef struct {
+    uint16_t count;
+    uint16_t max;
+    uint16_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+// printable name of each latency_class, for reports
+extern const char *const latency_class_names[LAT_CLASS_COUNT];
+
+// physical key number of every matrix position, LAYER_KEYS laid out by the board's keymap.c
+extern const uint8_t PROGMEM key_index[MATRIX_ROWS][MATRIX_COLS];
+
+uint8_t               latency_class(uint16_t keycode, keyrecord_t *record);
+void                  latency_event(keyrecord_t *record);
+void                  latency_record(uint16_t keycode, keyrecord_t *record);
+const latency_hist_t *latency_hist(uint8_t profile, uint8_t which);
+uint16_t              latency_percentile(const latency_hist_t *hist, uint8_t percent);
+void                  latency_reset(void);
+void                  latency_report(void);
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "layer_index.h"
+#include "print.h"
+#ifdef REMAP_ENABLE
+#    include "remap.h"
+#endif
+
+_Static_assert(LAYER_COUNT <= 8, "layer_index keeps one byte of layer bits per key");
+
+/**
+ * Layer index
+ * Bit n is set when layer n has something other than KC_TRNS at that matrix position.
+ * A RAM bitmap built once from keymaps[] at boot and patched a key at a time on remaps,
+ * 1 byte per key; keymaps[] stays as it is, so flash is unchanged. It does not pick the
+ * owning layer: the core's walk does, see below.
+ */
+static uint8_t opaque[MATRIX_ROWS][MATRIX_COLS];
+static bool    ready = false;
+
+// the RAM copy with its remapped keys when there is one, keymaps[] otherwise
+static uint16_t keymap_read(uint8_t layer, uint8_t row, uint8_t col) {
+#ifdef REMAP_ENABLE
+    return remap_keycode(layer, row, col);
+#else
+    return keycode_at_keymap_location_raw(layer, row, col);
+#endif
+}
+
+void layer_index_init(void) {
+    uint8_t layers = MIN(keymap_layer_count(), LAYER_COUNT);
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint8_t bits = 0;
+            for (uint8_t layer = 0; layer < layers; layer++) {
+                if (keymap_read(layer, row, col) != KC_TRNS) {
+                    bits |= 1 << layer;
+                }
+            }
+            opaque[row][col] = bits;
+        }
+    }
+    ready = true;
+}
+
+// a key was remapped, it may have become transparent or stopped being so
+void layer_index_update(uint8_t layer, uint8_t row, uint8_t col) {
+    if (layer >= LAYER_COUNT || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+        return;
+    }
+    if (keymap_read(layer, row, col) != KC_TRNS) {
+        opaque[row][col] |= 1 << layer;
+    } else {
+        opaque[row][col] &= ~(1 << layer);
+    }
+}
+
+// layers that define the key at this position
+uint8_t layer_index_layers(uint8_t row, uint8_t col) {
+    return opaque[row][col];
+}
+
+/**
+ * Keymap reads
+ * The core still resolves a key by walking the active layers top down in
+ * layer_switch_get_layer(), which is not weak and is called from within its own file, so
+ * there is nothing to hook for a single bit-scan. Each step of the walk lands here, and
+ * the bitmap answers the transparent ones without reading keymaps[]
+ */
+uint16_t keycode_at_keymap_location(uint8_t layer, uint8_t row, uint8_t column) {
+    if (ready && layer < LAYER_COUNT && row < MATRIX_ROWS && column < MATRIX_COLS && !(opaque[row][column] & (1 << layer))) {
+        return KC_TRNS;
+    }
+    return keymap_read(layer, row, column);
+}
+
+// keys each layer actually defines, out of the MATRIX_ROWS * MATRIX_COLS every layer stores
+void layer_index_report(void) {
+    uprintf("layers (keys defined of %u)", MATRIX_ROWS * MATRIX_COLS);
+    for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+        uint8_t keys = 0;
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keys += (opaque[row][col] >> layer) & 1;
+            }
+        }
+        uprintf(" %u", keys);
+    }
+    uprintf("\n");
+}
@@ -0,0 +1,9 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+void    layer_index_init(void);
+void    layer_index_update(uint8_t layer, uint8_t row, uint8_t col);
+uint8_t layer_index_layers(uint8_t row, uint8_t col);
+void    layer_index_report(void);
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+/**
+ * Shared layout
+ * Every layer is written once, as the 44 keys both boards have. A board's keymap.c lays
+ * them out with LAYOUT_luke(), which on the Iris CE puts the matching _NUMBERS row on top.
+ * LAYER_DFLT also feeds the generated tap-hold table, so both always see the same keys.
+ */
+#define LAYER_DFLT                                                                                                                                 \
+    /* ┌────────┬────────┬────────┬────────┬────────┬────────┐                          ┌────────┬────────┬────────┬────────┬────────┬────────┐ */ \
+        KC_TAB,  KC_Q,    KC_W,    KC_F,    KC_P,    KC_B,                               KC_J,    KC_L,    KC_U,    KC_Y,    KC_QUOT, KC_BSLS,     \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┤                          ├────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        SYS_ESC, HRM_A,   HRM_R,   HRM_S,   HRM_T,   KC_G,                               KC_M,    HRM_N,   HRM_E,   HRM_I,   HRM_O,   SYS_QUOT,    \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┼────────┐        ┌────────┼────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        KC_MEH,  KC_Z,    KC_X,    KC_C,    KC_D,    KC_V,    NUM_ENT,          NUM_ENT, KC_K,    KC_H,    KC_COMM, KC_DOT,  KC_SLSH, KC_MEH,      \
+    /* └────────┴────────┴────────┴───┬────┴───┬────┴───┬────┴───┬────┘        └───┬────┴───┬────┴───┬────┴───┬────┴────────┴────────┴────────┘ */ \
+                                       KC_HYPR, KC_LSFT, NAV_BS,                    NAV_SPC, MO(NUM), KC_HYPR                                      \
+    /*                                └────────┴────────┴────────┘                 └────────┴────────┴────────┘ */
+
+#define LAYER_GAME                                                                                                                                 \
+    /* ┌────────┬────────┬────────┬────────┬────────┬────────┐                          ┌────────┬────────┬────────┬────────┬────────┬────────┐ */ \
+        _______, KC_I,    KC_Q,    KC_W,    KC_E,    KC_R,                               _______, _______, _______, _______, _______, _______,     \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┤                          ├────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        KC_ESC,  KC_LSFT, KC_A,    KC_S,    KC_D,    KC_F,                               _______, KC_N,    KC_E,    KC_I,    KC_O,    KC_QUOT,     \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┼────────┐        ┌────────┼────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        _______, KC_Z,    KC_X,    KC_C,    KC_M,    KC_V,    KC_ENT,           KC_ENT,  _______, _______, _______, _______, _______, MO(SYS),     \
+    /* └────────┴────────┴────────┴───┬────┴───┬────┴───┬────┴───┬────┘        └───┬────┴───┬────┴───┬────┴───┬────┴────────┴────────┴────────┘ */ \
+                                       _______, MO(NAV), KC_SPC,                    KC_SPC,  _______, _______                                      \
+    /*                                └────────┴────────┴────────┘                 └────────┴────────┴────────┘ */
+
+#define LAYER_NAV                                                                                                                                  \
+    /* ┌────────┬────────┬────────┬────────┬────────┬────────┐                          ┌────────┬────────┬────────┬────────┬────────┬────────┐ */ \
+        _______, _______, KC_BSPC, KC_UP,   KC_DEL,  KC_LBRC,                            KC_RBRC, KC_GRV,  KC_PLUS, KC_PIPE, KC_COLN, KC_PIPE,     \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┤                          ├────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        PTR_MOD, KC_LSFT, KC_LEFT, KC_DOWN, KC_RIGHT,KC_LPRN,                            KC_RPRN, KC_MINS, KC_EQL,  KC_BSLS, KC_SCLN, KC_DQUO,     \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┼────────┐        ┌────────┼────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        _______, KC_LGUI, _______, KC_HOME, KC_END,  KC_LCBR, MS_BTN2,          _______, KC_RCBR, KC_UNDS, KC_LT,   KC_GT,   KC_QUES, _______,     \
+    /* └────────┴────────┴────────┴───┬────┴───┬────┴───┬────┴───┬────┘        └───┬────┴───┬────┴───┬────┴───┬────┴────────┴────────┴────────┘ */ \
+                                       MS_BTN1, _______, _______,                   _______, _______, _______                                      \
+    /*                                └────────┴────────┴────────┘                 └────────┴────────┴────────┘ */
+
+#define LAYER_SYS                                                                                                                                  \
+    /* ┌────────┬────────┬────────┬────────┬────────┬────────┐                          ┌────────┬────────┬────────┬────────┬────────┬────────┐ */ \
+        _______, TO(DFLT),TO(GAME),MC_TODO, MC_QMK,  _______,                            STAT_RPT,HRM_RST, _______, _______, _______, _______,     \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┤                          ├────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        _______, _______, KC_VOLU, KC_MPLY, KC_MNXT, KC_BRIU,                            RM_VALU, _______, _______, _______, _______, _______,     \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┼────────┐        ┌────────┼────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        QK_BOOT, _______, KC_VOLD, KC_MUTE, KC_MPRV, KC_BRID, _______,          _______, RM_VALD, _______, _______, _______, _______, QK_BOOT,     \
+    /* └────────┴────────┴────────┴───┬────┴───┬────┴───┬────┴───┬────┘        └───┬────┴───┬────┴───┬────┴───┬────┴────────┴────────┴────────┘ */ \
+                                       _______, _______, _______,                   _______, _______, _______                                      \
+    /*                                └────────┴────────┴────────┘                 └────────┴────────┴────────┘ */
+
+#define LAYER_NUM                                                                                                                                  \
+    /* ┌────────┬────────┬────────┬────────┬────────┬────────┐                          ┌────────┬────────┬────────┬────────┬────────┬────────┐ */ \
+        MC_ARROW,KC_EXLM, KC_AT,   KC_HASH, KC_DLR,  KC_PERC,                            KC_CIRC, KC_AMPR, KC_ASTR, KC_LPRN, KC_RPRN, MC_FATAR,    \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┤                          ├────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        _______, KC_1,    KC_2,    KC_3,    KC_4,    KC_5,                               KC_6,    KC_7,    KC_8,    KC_9,    KC_0,    _______,     \
+    /* ├────────┼────────┼────────┼────────┼────────┼────────┼────────┐        ┌────────┼────────┼────────┼────────┼────────┼────────┼────────┤ */ \
+        KC_F12,  KC_F1,   KC_F2,   KC_F3,   KC_F4,   KC_F5,   _______,          _______, KC_F6,   KC_F7,   KC_F8,   KC_F9,   KC_F10,  KC_F11,      \
+    /* └────────┴────────┴────────┴───┬────┴───┬────┴───┬────┴───┬────┘        └───┬────┴───┬────┴───┬────┴───┬────┴────────┴────────┴────────┘ */ \
+                                       _______, _______, _______,                   _______, _______, _______                                      \
+    /*                                └────────┴────────┴────────┘                 └────────┴────────┴────────┘ */
+
+/**
+ * Fingers
+ * Which finger types each key, laid out like the layers, for the analytics in analytics.c
+ */
+enum finger { F_LP, F_LR, F_LM, F_LI, F_LT, F_RT, F_RI, F_RM, F_RR, F_RP };
+
+#define LAYER_FINGERS                                                                   \
+    F_LP, F_LP, F_LR, F_LM, F_LI, F_LI,             F_RI, F_RI, F_RM, F_RR, F_RP, F_RP, \
+    F_LP, F_LP, F_LR, F_LM, F_LI, F_LI,             F_RI, F_RI, F_RM, F_RR, F_RP, F_RP, \
+    F_LP, F_LP, F_LR, F_LM, F_LI, F_LI, F_LI, F_RI, F_RI, F_RI, F_RM, F_RR, F_RP, F_RP, \
+                      F_LT, F_LT, F_LT,             F_RT, F_RT, F_RT
+
+/**
+ * Key numbers
+ * Names every physical key independently of the board's matrix, laid out like the layers:
+ * 1-44 for the shared keys and 45-56 for the Iris CE number row. Latency traces are
+ * recorded and replayed in these, see latency.c and tests/README.md
+ */
+#define LAYER_KEYS                                               \
+     1,  2,  3,  4,  5,  6,          7,  8,  9, 10, 11, 12,     \
+    13, 14, 15, 16, 17, 18,         19, 20, 21, 22, 23, 24,     \
+    25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38,     \
+                    39, 40, 41,         42, 43, 44
+
+// Iris CE number row, one per layer
+#define LAYER_DFLT_NUMBERS QK_GESC, KC_1, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0, _______
+#define LAYER_GAME_NUMBERS _______, _______, _______, _______, _______, _______, _______, _______, _______, _______, _______, _______
+#define LAYER_NAV_NUMBERS  KC_TILDE, KC_EXLM, KC_AT, KC_HASH, KC_DLR, KC_PERC, KC_CIRC, KC_AMPR, KC_ASTR, KC_LPRN, KC_RPRN, _______
+#define LAYER_SYS_NUMBERS  KC_F12, KC_F1, KC_F2, KC_F3, KC_F4, KC_F5, KC_F6, KC_F7, KC_F8, KC_F9, KC_F10, KC_F11
+#define LAYER_NUM_NUMBERS  KC_F12, KC_F1, KC_F2, KC_F3, KC_F4, KC_F5, KC_F6, KC_F7, KC_F8, KC_F9, KC_F10, KC_F11
+#define LAYER_FINGERS_NUMBERS F_LP, F_LP, F_LR, F_LM, F_LI, F_LI, F_RI, F_RI, F_RM, F_RR, F_RP, F_RP
+#define LAYER_KEYS_NUMBERS 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56
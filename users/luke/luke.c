@@ -0,0 +1,359 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "luke.h"
+#include "indicator.h"
+#include "game_mode.h"
+#include "fuzz.h"
+#include "layer_index.h"
+#include "rgb_gate.h"
+#include "profile.h"
+#include "sched.h"
+#include "settings.h"
+#ifdef LATENCY_ENABLE
+#    include "latency.h"
+#endif
+#ifdef ADAPTIVE_TERM_ENABLE
+#    include "adaptive_term.h"
+#endif
+#ifdef SPLIT_SYNC_ENABLE
+#    include "split_sync.h"
+#endif
+#ifdef SPLIT_PROBE_ENABLE
+#    include "split_probe.h"
+#endif
+#ifdef COMBO_ENGINE_ENABLE
+#    include "combo_engine.h"
+#endif
+#ifdef MACRO_SENDER_ENABLE
+#    include "macro_sender.h"
+#endif
+#ifdef ANALYTICS_ENABLE
+#    include "analytics.h"
+#endif
+#ifdef POINTER_ENABLE
+#    include "pointer.h"
+#endif
+#ifdef TAP_TELEMETRY_ENABLE
+#    include "tap_telemetry.h"
+#endif
+#ifdef GOVERNOR_ENABLE
+#    include "governor.h"
+#endif
+#ifdef SPECULATIVE_TAP_ENABLE
+#    include "speculative_tap.h"
+#endif
+#ifdef REMAP_ENABLE
+#    include "remap.h"
+#endif
+
+/**
+ * RGB SETTINGS
+ */
+void keyboard_post_init_user(void) {
+#ifdef PROFILE_ENABLE
+    profile_init();
+#endif
+#ifdef REMAP_ENABLE
+    // before the index, which is built from the remapped keys
+    remap_init();
+#endif
+    layer_index_init();
+    settings_init();
+#ifdef ADAPTIVE_TERM_ENABLE
+    adaptive_term_init();
+#endif
+#ifdef COMBO_ENGINE_ENABLE
+    combo_engine_init();
+#endif
+#ifdef ANALYTICS_ENABLE
+    analytics_init();
+#endif
+
+    rgb_matrix_enable_noeeprom();
+    indicator_init();
+
+#ifdef SPLIT_SYNC_ENABLE
+    split_sync_init();
+#endif
+#ifdef SPLIT_PROBE_ENABLE
+    split_probe_init();
+#endif
+}
+
+/**
+ * matrix scans, after the core has read both halves and before key events are made
+ */
+void matrix_scan_user(void) {
+    PROFILE_BEGIN(PROF_MATRIX_SCAN);
+#ifdef FUZZ_ENABLE
+    fuzz_scan();
+#endif
+#ifdef SPLIT_PROBE_ENABLE
+    split_probe_scan();
+#endif
+    PROFILE_END(PROF_MATRIX_SCAN);
+}
+
+#ifdef SPLIT_PROBE_ENABLE
+void matrix_slave_scan_user(void) {
+    split_probe_slave_scan();
+}
+#endif
+
+layer_state_t layer_state_set_user(layer_state_t state) {
+    PROFILE_BEGIN(PROF_LAYER_STATE);
+    state = game_mode_layer_state(state);
+    state = indicator_layer_state(state);
+    PROFILE_END(PROF_LAYER_STATE);
+    return state;
+}
+
+#ifdef RGB_MATRIX_ENABLE
+bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
+    indicator_render(led_min, led_max);
+    if (led_max >= RGB_MATRIX_LED_COUNT) {
+        rgb_gate_frame();
+    }
+    return false;
+}
+#endif
+
+/**
+ * raw key events, ahead of the tap-hold machinery
+ */
+bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    bool pass = true;
+    PROFILE_BEGIN(PROF_PRE_PROCESS);
+
+#ifdef FUZZ_ENABLE
+    fuzz_event(keycode, record);
+#endif
+#ifdef LATENCY_ENABLE
+    latency_event(record);
+#endif
+#ifdef TAP_TELEMETRY_ENABLE
+    tap_telemetry_event(keycode, record);
+#endif
+#ifdef SPLIT_PROBE_ENABLE
+    split_probe_event(record);
+#endif
+#ifdef COMBO_ENGINE_ENABLE
+    pass = combo_engine_process(keycode, record);
+#endif
+#ifdef SPECULATIVE_TAP_ENABLE
+    if (pass) {
+        speculative_tap_event(keycode, record);
+    }
+#endif
+
+    PROFILE_END(PROF_PRE_PROCESS);
+    return pass;
+}
+
+/**
+ * custom keycodes
+ */
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+#ifdef FUZZ_ENABLE
+    // first, so it sees every settled press and can keep a stream inside the keyboard
+    if (!fuzz_process(keycode, record)) {
+        return false;
+    }
+#endif
+#ifdef SPECULATIVE_TAP_ENABLE
+    if (!speculative_tap_process(keycode, record)) {
+        // the letter is already out, but the core skips post processing for swallowed
+        // events and the tap still counts for the learners
+        post_process_record_user(keycode, record);
+        return false;
+    }
+#endif
+#ifdef POINTER_ENABLE
+    if (!pointer_process(keycode, record)) {
+        return false;
+    }
+#endif
+
+    switch (keycode) {
+        // brightness is persisted through the settings journal instead of the rgb eeconfig block
+        case RM_VALU:
+        case RM_VALD:
+            if (record->event.pressed) {
+                // stepped from the indicator, the live value is dimmed on highlighted layers
+                bool    shifted = (get_mods() | get_oneshot_mods()) & MOD_MASK_SHIFT;
+                uint8_t val     = indicator_brightness();
+                if ((keycode == RM_VALU) != shifted) {
+                    val = MIN(val + RGB_MATRIX_VAL_STEP, RGB_MATRIX_MAXIMUM_BRIGHTNESS);
+                } else {
+                    val = val > RGB_MATRIX_VAL_STEP ? val - RGB_MATRIX_VAL_STEP : 0;
+                }
+                indicator_set_brightness(val);
+                settings_set(SETTING_BRIGHTNESS, val);
+            }
+            return false;
+        case STAT_RPT:
+            if (record->event.pressed) {
+#ifdef LATENCY_ENABLE
+                latency_report();
+#endif
+#ifdef ADAPTIVE_TERM_ENABLE
+                adaptive_term_report();
+#endif
+#ifdef SPLIT_SYNC_ENABLE
+                split_sync_report();
+#endif
+#ifdef SPLIT_PROBE_ENABLE
+                split_probe_report();
+#endif
+#ifdef COMBO_ENGINE_ENABLE
+                combo_engine_report();
+#endif
+#ifdef MACRO_SENDER_ENABLE
+                macro_sender_report();
+#endif
+#ifdef ANALYTICS_ENABLE
+                analytics_report();
+#endif
+#ifdef TAP_TELEMETRY_ENABLE
+                tap_telemetry_report();
+#endif
+#ifdef SPECULATIVE_TAP_ENABLE
+                speculative_tap_report();
+#endif
+#ifdef PROFILE_ENABLE
+                profile_report();
+#endif
+                layer_index_report();
+#ifdef REMAP_ENABLE
+                remap_report();
+#endif
+#ifdef RGB_MATRIX_ENABLE
+                rgb_gate_report();
+#endif
+#ifdef GOVERNOR_ENABLE
+                governor_report();
+#endif
+#ifdef FUZZ_ENABLE
+                fuzz_report();
+#endif
+                settings_report();
+            }
+            return false;
+        case HRM_RST:
+#ifdef ADAPTIVE_TERM_ENABLE
+            if (record->event.pressed) {
+                adaptive_term_reset();
+            }
+#endif
+            return false;
+    }
+
+#ifdef MACRO_SENDER_ENABLE
+    // shifted plays through send_string instead, for the comparison in STAT_RPT
+    if (keycode >= MACRO_FIRST && keycode < CUSTOM_KEYCODE_END) {
+        if (record->event.pressed) {
+            if ((get_mods() | get_oneshot_mods()) & MOD_MASK_SHIFT) {
+                macro_sender_compare(keycode - MACRO_FIRST);
+            } else {
+                macro_sender_play(keycode - MACRO_FIRST);
+            }
+        }
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+/**
+ * per keny handling
+ */
+void post_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    PROFILE_BEGIN(PROF_POST_PROCESS);
+
+#ifdef LATENCY_ENABLE
+    latency_record(keycode, record);
+#endif
+#ifdef ANALYTICS_ENABLE
+    analytics_record(record);
+#endif
+#ifdef TAP_TELEMETRY_ENABLE
+    tap_telemetry_record(keycode, record);
+#endif
+#ifdef COMBO_ENGINE_ENABLE
+    combo_engine_settled(record);
+#endif
+#ifdef ADAPTIVE_TERM_ENABLE
+    // GAME presses and fuzz streams say nothing about typing, keep them out of the learned terms
+    if (!game_mode_is_active() && !fuzz_running()) {
+        adaptive_term_record(keycode, record);
+    }
+#endif
+
+    PROFILE_END(PROF_POST_PROCESS);
+}
+
+void housekeeping_task_user(void) {
+    PROFILE_BEGIN(PROF_HOUSEKEEPING);
+
+    sched_task();
+#ifdef MACRO_SENDER_ENABLE
+    macro_sender_task();
+#endif
+#ifdef POINTER_ENABLE
+    pointer_task();
+#endif
+#ifdef ANALYTICS_ENABLE
+    analytics_task();
+#endif
+#ifdef SPLIT_SYNC_ENABLE
+    split_sync_task();
+#endif
+#ifdef FUZZ_ENABLE
+    fuzz_task();
+#endif
+
+    PROFILE_END(PROF_HOUSEKEEPING);
+#ifdef PROFILE_ENABLE
+    profile_scan();
+#endif
+#ifdef GOVERNOR_ENABLE
+    // last, its sleep is the gap before the next scan and shows in no hook's timing
+    governor_task();
+#endif
+}
+
+#ifdef RAW_ENABLE
+/**
+ * raw hid, dispatched on the first byte, see enum raw_command
+ */
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+#    ifdef ANALYTICS_ENABLE
+        case RAW_ANALYTICS_READ:
+        case RAW_ANALYTICS_RESET:
+            analytics_raw(data, length);
+            break;
+#    endif
+#    ifdef REMAP_ENABLE
+        case RAW_REMAP_INFO:
+        case RAW_REMAP_GET:
+        case RAW_REMAP_SET:
+        case RAW_REMAP_RESET:
+            remap_raw(data, length);
+            break;
+#    endif
+#    ifdef FUZZ_ENABLE
+        case RAW_FUZZ_INFO:
+        case RAW_FUZZ_LOAD:
+        case RAW_FUZZ_RUN:
+        case RAW_FUZZ_STATUS:
+            fuzz_raw(data, length);
+            break;
+#    endif
+        default:
+            data[0] = RAW_UNHANDLED;
+            break;
+    }
+    raw_hid_send(data, length);
+}
+#endif
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Named HSV tuples for readability
+#define WHITE       0, 0
+#define RED         0, 255
+#define GREEN      85, 255
+#define BLUE      170, 255
+#define PURPLE    191, 255
+
+enum custom_layers {
+     DFLT,
+     GAME,
+     NAV,
+     SYS,
+     NUM,
+     LAYER_COUNT
+};
+
+/**
+ * Text macros
+ * One keycode per entry, streamed by macro_sender.c several keys per report
+ */
+#define MACRO_SPEC(X)                              \
+    X(MC_ARROW, "->")                              \
+    X(MC_FATAR, "=>")                              \
+    X(MC_TODO,  "TODO(luke): ")                    \
+    X(MC_QMK,   "qmk compile -km luke\n")
+
+#define MACRO_KEYCODE(name, text) name,
+
+enum custom_keycodes {
+    STAT_RPT = SAFE_RANGE, // print userspace stats over the console
+    HRM_RST,               // forget the learned home row mod terms (ADAPTIVE_TERM_ENABLE)
+    PTR_MOD,               // hold to steer the pointer with the NAV arrows (POINTER_ENABLE)
+    MACRO_SPEC(MACRO_KEYCODE)
+    CUSTOM_KEYCODE_END
+};
+
+// raw hid commands, the first byte of every report in both directions
+enum raw_command {
+    RAW_ANALYTICS_READ = 0x01, // offset in bytes 1-2, see analytics.c
+    RAW_ANALYTICS_RESET,
+    RAW_REMAP_INFO = 0x10, // see remap.c
+    RAW_REMAP_GET,
+    RAW_REMAP_SET,
+    RAW_REMAP_RESET,
+    RAW_FUZZ_INFO = 0x20, // see fuzz.c
+    RAW_FUZZ_LOAD,
+    RAW_FUZZ_RUN,
+    RAW_FUZZ_STATUS,
+    RAW_UNHANDLED = 0xFF,
+};
+
+// key tap aliases
+#define LSG_S LSG(KC_S)
+
+// home row mod aliases
+#define HRM_A MT(MOD_LCTL, KC_A)
+#define HRM_R MT(MOD_LALT, KC_R)
+#define HRM_S MT(MOD_LGUI, KC_S)
+#define HRM_T MT(MOD_LSFT, KC_T)
+
+#define HRM_O MT(MOD_RCTL, KC_O)
+#define HRM_I MT(MOD_LALT, KC_I)
+#define HRM_E MT(MOD_RGUI, KC_E)
+#define HRM_N MT(MOD_RSFT, KC_N)
+
+// layer tap aliases
+#define NAV_BS LT(NAV, KC_BSPC)
+#define NAV_SPC LT(NAV, KC_SPC)
+#define NUM_ENT LT(NUM, KC_ENT)
+#define SYS_ESC LT(SYS, KC_ESC)
+#define SYS_QUOT LT(SYS, KC_QUOT)
+
+// lets a layer defined as a macro list expand before LAYOUT() counts its arguments
+#define LAYOUT_wrapper(...) LAYOUT(__VA_ARGS__)
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "macro_sender.h"
+#include "print.h"
+#include "send_string.h"
+#include "timer_us.h"
+
+/**
+ * Macro text
+ * Stored as plain ASCII in flash and turned into keycodes with send_string's own lookup
+ * tables as it plays; a precomputed keycode and shift byte would take the same space
+ */
+#define MACRO_TEXT(name, text) [name##_ID] = text,
+
+static const char *const PROGMEM macro_texts[MACRO_COUNT] = {MACRO_SPEC(MACRO_TEXT)};
+
+static const char *playing;
+static uint8_t     chunk[MACRO_KEYS_PER_REPORT];
+static uint8_t     chunk_len;
+static bool        chunk_shift;
+static uint32_t    last_report;
+static uint32_t    play_start;
+
+static struct {
+    uint16_t chars;
+    uint16_t waits;
+    uint16_t reports;
+    uint32_t packed_us;
+    uint16_t compare_chars;
+    uint32_t compare_us;
+} stats;
+
+void macro_sender_play(uint8_t macro) {
+    if (playing || macro >= MACRO_COUNT) {
+        return;
+    }
+    playing       = (const char *)pgm_read_ptr(&macro_texts[macro]);
+    play_start    = timer_read_us();
+    last_report   = play_start - MACRO_REPORT_INTERVAL_US;
+    stats.chars   = 0;
+    stats.waits   = 0;
+    stats.reports = 0;
+}
+
+/**
+ * Comparison
+ * Plays the same text through send_string_P, which blocks, for the chars per second
+ * figure in macro_sender_report
+ */
+void macro_sender_compare(uint8_t macro) {
+    if (playing || macro >= MACRO_COUNT) {
+        return;
+    }
+    const char *text  = (const char *)pgm_read_ptr(&macro_texts[macro]);
+    uint8_t     mods  = get_mods();
+    uint32_t    start = timer_read_us();
+
+    // the shift that asked for the comparison must not reach the text
+    clear_mods();
+    send_string_P(text);
+    stats.compare_us = timer_elapsed_us(start);
+    set_mods(mods);
+    send_keyboard_report();
+    stats.compare_chars = strlen_P(text);
+}
+
+bool macro_sender_busy(void) {
+    return playing != NULL;
+}
+
+// the host already has the key down, most likely because it is being held
+static bool in_report(uint8_t keycode) {
+#ifdef NKRO_ENABLE
+    if (keymap_config.nkro) {
+        return (keycode >> 3) < NKRO_REPORT_BITS && (nkro_report->bits[keycode >> 3] & (1 << (keycode & 7)));
+    }
+#endif
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (keyboard_report->keys[i] == keycode) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool in_chunk(uint8_t keycode) {
+    for (uint8_t i = 0; i < chunk_len; i++) {
+        if (chunk[i] == keycode) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// no free slot in a 6KRO report, the keys someone holds take theirs
+static bool report_full(void) {
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (!keyboard_report->keys[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void release_chunk(void) {
+    for (uint8_t i = 0; i < chunk_len; i++) {
+        del_key(chunk[i]);
+    }
+    if (chunk_shift) {
+        del_weak_mods(MOD_BIT(KC_LSFT));
+    }
+    chunk_len = 0;
+}
+
+/**
+ * Packing
+ * Takes characters while their keycodes are distinct and they share the shift state.
+ * The host reads new keys in report order, except an NKRO bitmap which it reads in
+ * keycode order, so there a chunk only grows while keycodes ascend. A repeat ends the
+ * chunk and goes out after its release. A key that is down outside the chunk is held by
+ * someone: typing it would mean releasing it under them, so the chunk ends there and
+ * playback waits until it is let go, rather than dropping the character.
+ */
+static void press_chunk(void) {
+    bool nkro = false;
+#ifdef NKRO_ENABLE
+    nkro = keymap_config.nkro;
+#endif
+
+    while (chunk_len < MACRO_KEYS_PER_REPORT) {
+        uint8_t ascii = pgm_read_byte(playing);
+        if (!ascii) {
+            break;
+        }
+        if (ascii & 0x80) {
+            playing++;
+            continue;
+        }
+
+        uint8_t keycode = pgm_read_byte(&ascii_to_keycode_lut[ascii]);
+        bool    shift   = PGM_LOADBIT(ascii_to_shift_lut, ascii);
+        if (chunk_len && (shift != chunk_shift || (nkro && keycode <= chunk[chunk_len - 1]) || in_chunk(keycode))) {
+            break;
+        }
+        if (in_report(keycode)) {
+            stats.waits += !chunk_len;
+            break;
+        }
+        if (!nkro && report_full()) {
+            break;
+        }
+
+        chunk_shift        = shift;
+        chunk[chunk_len++] = keycode;
+        add_key(keycode);
+        playing++;
+        stats.chars++;
+    }
+
+    if (chunk_len && chunk_shift) {
+        add_weak_mods(MOD_BIT(KC_LSFT));
+    }
+}
+
+/**
+ * Playback
+ * Streams from housekeeping one report per polling interval, alternating a chunk of
+ * presses with its release, so the scan loop never waits on the host
+ */
+void macro_sender_task(void) {
+    if (!playing || timer_elapsed_us(last_report) < MACRO_REPORT_INTERVAL_US) {
+        return;
+    }
+
+    if (chunk_len) {
+        release_chunk();
+    } else {
+        press_chunk();
+        // waiting on a held key, nothing changed to send
+        if (!chunk_len && pgm_read_byte(playing)) {
+            last_report = timer_read_us();
+            return;
+        }
+    }
+    if (!chunk_len && !pgm_read_byte(playing)) {
+        playing         = NULL;
+        stats.packed_us = timer_elapsed_us(play_start);
+    }
+
+    send_keyboard_report();
+    last_report = timer_read_us();
+    stats.reports++;
+}
+
+static uint32_t chars_per_sec(uint16_t chars, uint32_t us) {
+    return us ? (uint32_t)chars * 1000000 / us : 0;
+}
+
+// last packed playback against the last shifted (send_string) one
+void macro_sender_report(void) {
+    uprintf("macro packed %u chars (%u waits on a held key) %u reports %lu cps, send_string %u chars %lu cps\n", stats.chars, stats.waits, stats.reports, chars_per_sec(stats.chars, stats.packed_us),
+            stats.compare_chars, chars_per_sec(stats.compare_chars, stats.compare_us));
+}
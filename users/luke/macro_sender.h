@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+#define MACRO_ID(name, text) name##_ID,
+enum macro_id { MACRO_SPEC(MACRO_ID) MACRO_COUNT };
+
+#define MACRO_FIRST (CUSTOM_KEYCODE_END - MACRO_COUNT)
+
+// most keys pressed in one report, a full 6KRO report by default; relies on the host
+// reading new keys in report order, 1 behaves like send_string with one key at a time
+#ifndef MACRO_KEYS_PER_REPORT
+#    define MACRO_KEYS_PER_REPORT KEYBOARD_REPORT_KEYS
+#endif
+
+// time between reports, one USB polling interval
+#ifndef MACRO_REPORT_INTERVAL_US
+#    define MACRO_REPORT_INTERVAL_US 1000
+#endif
+
+void macro_sender_play(uint8_t macro);
+void macro_sender_compare(uint8_t macro);
+bool macro_sender_busy(void);
+void macro_sender_task(void);
+void macro_sender_report(void);
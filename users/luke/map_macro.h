@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+/**
+ * MAP_LIST(f, ...)
+ * Applies f to every argument and keeps the results comma separated, so a keymap layer
+ * can be fed back through LAYOUT() to build per-position tables at compile time.
+ * Based on William Swanson's public domain map-macro; good for a few hundred arguments.
+ */
+#define MAP_EVAL0(...) __VA_ARGS__
+#define MAP_EVAL1(...) MAP_EVAL0(MAP_EVAL0(MAP_EVAL0(__VA_ARGS__)))
+#define MAP_EVAL2(...) MAP_EVAL1(MAP_EVAL1(MAP_EVAL1(__VA_ARGS__)))
+#define MAP_EVAL3(...) MAP_EVAL2(MAP_EVAL2(MAP_EVAL2(__VA_ARGS__)))
+#define MAP_EVAL4(...) MAP_EVAL3(MAP_EVAL3(MAP_EVAL3(__VA_ARGS__)))
+#define MAP_EVAL(...)  MAP_EVAL4(MAP_EVAL4(MAP_EVAL4(__VA_ARGS__)))
+
+#define MAP_END(...)
+#define MAP_OUT
+#define MAP_COMMA ,
+
+#define MAP_GET_END2()             0, MAP_END
+#define MAP_GET_END1(...)          MAP_GET_END2
+#define MAP_GET_END(...)           MAP_GET_END1
+#define MAP_NEXT0(test, next, ...) next MAP_OUT
+
+#define MAP_LIST_NEXT1(test, next) MAP_NEXT0(test, MAP_COMMA next, 0)
+#define MAP_LIST_NEXT(test, next)  MAP_LIST_NEXT1(MAP_GET_END test, next)
+
+#define MAP_LIST0(f, x, peek, ...) f(x) MAP_LIST_NEXT(peek, MAP_LIST1)(f, peek, __VA_ARGS__)
+#define MAP_LIST1(f, x, peek, ...) f(x) MAP_LIST_NEXT(peek, MAP_LIST0)(f, peek, __VA_ARGS__)
+
+#define MAP_LIST(f, ...) MAP_EVAL(MAP_LIST1(f, __VA_ARGS__, ()()(), ()()(), ()()(), 0))
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "pointer.h"
+#include "pointer_curve.h"
+#include "host.h"
+#include "mousekey.h"
+#include "profile.h"
+#include "timer.h"
+
+enum pointer_dir {
+    DIR_UP    = 1 << 0,
+    DIR_DOWN  = 1 << 1,
+    DIR_LEFT  = 1 << 2,
+    DIR_RIGHT = 1 << 3,
+};
+
+typedef struct {
+    int16_t v;   // Q8 pixels per millisecond
+    int32_t pos; // Q8 pixels not reported yet
+} pointer_axis_t;
+
+static pointer_axis_t x, y;
+static bool           steering  = false; // PTR_MOD is held
+static uint8_t        captured  = 0;     // arrow presses taken over by the pointer
+static uint16_t       held_ms   = 0;     // time a direction has been held, for the curve
+static uint16_t       last_step = 0;
+
+static uint8_t arrow_dir(uint16_t keycode) {
+    switch (keycode) {
+        case KC_UP:
+            return DIR_UP;
+        case KC_DOWN:
+            return DIR_DOWN;
+        case KC_LEFT:
+            return DIR_LEFT;
+        case KC_RIGHT:
+            return DIR_RIGHT;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Keys
+ * While PTR_MOD is held the NAV arrows steer the pointer instead of the cursor. An
+ * arrow keeps steering until it is released, so letting go of PTR_MOD first never
+ * leaves an arrow release without its press.
+ */
+bool pointer_process(uint16_t keycode, keyrecord_t *record) {
+    if (keycode == PTR_MOD) {
+        steering = record->event.pressed;
+        return false;
+    }
+
+    uint8_t dir = arrow_dir(keycode);
+    if (!dir) {
+        return true;
+    }
+    if (record->event.pressed && steering) {
+        if (!captured && !x.v && !y.v) {
+            last_step = timer_read();
+        }
+        captured |= dir;
+        return false;
+    }
+    if (!record->event.pressed && (captured & dir)) {
+        captured &= ~dir;
+        return false;
+    }
+    return true;
+}
+
+// moves the velocity part of the way to the target, the last units one at a time
+static void pointer_axis_step(pointer_axis_t *axis, int16_t target, uint8_t shift) {
+    int16_t delta = target - axis->v;
+    int16_t step  = delta >> shift;
+    if (!step) {
+        step = (delta > 0) - (delta < 0);
+    }
+    axis->v += step;
+    axis->pos += axis->v;
+}
+
+static int8_t pointer_axis_take(pointer_axis_t *axis) {
+    int32_t move = axis->pos >> 8;
+    if (move > 127) {
+        move = 127;
+    } else if (move < -127) {
+        move = -127;
+    }
+    axis->pos -= move << 8;
+    return move;
+}
+
+/**
+ * Engine
+ * Stepped per elapsed millisecond from housekeeping, sending at most one report per
+ * POINTER_REPORT_MS. The speed for the time held is one flash read; everything else is
+ * integer adds and shifts on Q8 fixed point, so a report costs the same at any speed.
+ */
+void pointer_task(void) {
+    if (!captured && !x.v && !y.v) {
+        return;
+    }
+    uint16_t elapsed = timer_elapsed(last_step);
+    if (elapsed < POINTER_REPORT_MS) {
+        return;
+    }
+    PROFILE_BEGIN(PROF_POINTER);
+    last_step += elapsed;
+
+    int8_t dx = !!(captured & DIR_RIGHT) - !!(captured & DIR_LEFT);
+    int8_t dy = !!(captured & DIR_DOWN) - !!(captured & DIR_UP);
+    for (uint8_t n = elapsed < POINTER_MAX_STEPS ? elapsed : POINTER_MAX_STEPS; n; n--) {
+        int16_t speed = 0;
+        if (dx || dy) {
+            uint8_t index = held_ms >> POINTER_CURVE_STEP_SHIFT;
+            speed         = pgm_read_word(&pointer_curve[index < POINTER_CURVE_LEN ? index : POINTER_CURVE_LEN - 1]);
+            if (dx && dy) {
+                speed = speed * POINTER_DIAGONAL >> 8;
+            }
+            if (held_ms < UINT16_MAX) {
+                held_ms++;
+            }
+        } else {
+            held_ms = 0;
+        }
+        pointer_axis_step(&x, dx * speed, dx ? POINTER_ACCEL_SHIFT : POINTER_FRICTION_SHIFT);
+        pointer_axis_step(&y, dy * speed, dy ? POINTER_ACCEL_SHIFT : POINTER_FRICTION_SHIFT);
+    }
+
+    report_mouse_t report = {
+        .buttons = mousekey_get_report().buttons,
+        .x       = pointer_axis_take(&x),
+        .y       = pointer_axis_take(&y),
+    };
+    if (report.x || report.y) {
+        host_mouse_send(&report);
+    }
+    PROFILE_END(PROF_POINTER);
+}
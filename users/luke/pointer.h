@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// milliseconds between mouse reports while the pointer moves
+#ifndef POINTER_REPORT_MS
+#    define POINTER_REPORT_MS 2
+#endif
+
+// each millisecond the velocity closes 1/2^n of the gap to the curve speed while a
+// direction is held, and to rest once none is; tools/pointer_sim.py mirrors both
+#ifndef POINTER_ACCEL_SHIFT
+#    define POINTER_ACCEL_SHIFT 3
+#endif
+#ifndef POINTER_FRICTION_SHIFT
+#    define POINTER_FRICTION_SHIFT 4
+#endif
+
+// milliseconds stepped at most for one report, so a stalled scan loop slows the pointer
+// down for a moment instead of making it jump
+#define POINTER_MAX_STEPS 8
+
+// 256 / sqrt(2), keeps diagonals at the curve speed
+#define POINTER_DIAGONAL 181
+
+bool pointer_process(uint16_t keycode, keyrecord_t *record);
+void pointer_task(void);
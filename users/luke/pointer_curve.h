@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// generated by tools/pointer_sim.py --header, edit the curve there
+#pragma once
+
+#define POINTER_CURVE_STEP_SHIFT 4
+#define POINTER_CURVE_LEN        64
+
+// Q8 pixels per millisecond, indexed by time held >> POINTER_CURVE_STEP_SHIFT
+static const uint16_t PROGMEM pointer_curve[POINTER_CURVE_LEN] = {
+     20,  21,  21,  21,  22,  23,  24,  25,  27,  28,  30,  32,  35,  37,  40,  43,
+     46,  49,  52,  56,  60,  64,  68,  72,  77,  82,  87,  92,  97, 103, 109, 115,
+    121, 127, 134, 141, 148, 155, 162, 170, 177, 185, 193, 202, 210, 219, 228, 237,
+    246, 256, 266, 275, 286, 296, 306, 317, 328, 339, 350, 362, 373, 385, 397, 410,
+};
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "profile.h"
+#include "print.h"
+#include "timer.h"
+
+typedef struct {
+    uint32_t calls;
+    uint32_t max;
+    uint32_t buckets[PROFILE_BUCKETS];
+} profile_hist_t;
+
+static profile_hist_t hists[PROF_HOOK_COUNT];
+static uint32_t       scans;
+static uint32_t       scans_timer;
+
+static const char *const hook_names[PROF_HOOK_COUNT] = {
+    [PROF_HOUSEKEEPING]   = "housekeeping_task_user",
+    [PROF_PRE_PROCESS]    = "pre_process_record_user",
+    [PROF_POST_PROCESS]   = "post_process_record_user",
+    [PROF_LAYER_STATE]    = "layer_state_set_user",
+    [PROF_RGB_TASK]       = "rgb_matrix_task",
+    [PROF_TAPPING_TERM]   = "get_tapping_term",
+    [PROF_QUICK_TAP_TERM] = "get_quick_tap_term",
+    [PROF_FLOW_TAP_TERM]  = "get_flow_tap_term",
+    [PROF_DEBOUNCE]       = "debounce",
+    [PROF_POINTER]        = "pointer_task",
+    [PROF_MATRIX_SCAN]    = "matrix_scan_user",
+};
+
+void profile_init(void) {
+    cycles_init();
+    scans_timer = timer_read32();
+}
+
+void profile_add(uint8_t hook, uint32_t cycles) {
+    profile_hist_t *hist   = &hists[hook];
+    uint8_t         bucket = cycles ? 32 - __builtin_clz(cycles) : 0;
+
+    if (bucket >= PROFILE_BUCKETS) {
+        bucket = PROFILE_BUCKETS - 1;
+    }
+    hist->buckets[bucket]++;
+    hist->calls++;
+    if (cycles > hist->max) {
+        hist->max = cycles;
+    }
+}
+
+void profile_scan(void) {
+    scans++;
+}
+
+/**
+ * Console dump
+ * One line per hook with the raw buckets, for users/luke/tools/profile_reader.py:
+ * prof <hook> <calls> <max> <bucket 0> ... <bucket 24>
+ */
+void profile_report(void) {
+    uint32_t elapsed = timer_elapsed32(scans_timer);
+    uprintf("prof scans_per_sec %lu\n", elapsed ? scans * 1000 / elapsed : 0);
+
+    for (uint8_t i = 0; i < PROF_HOOK_COUNT; i++) {
+        uprintf("prof %s %lu %lu", hook_names[i], hists[i].calls, hists[i].max);
+        for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+            uprintf(" %lu", hists[i].buckets[b]);
+        }
+        uprintf("\n");
+    }
+}
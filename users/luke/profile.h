@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <stdint.h>
+
+enum profile_hook {
+    PROF_HOUSEKEEPING,
+    PROF_PRE_PROCESS,
+    PROF_POST_PROCESS,
+    PROF_LAYER_STATE,
+    PROF_RGB_TASK,
+    PROF_TAPPING_TERM,
+    PROF_QUICK_TAP_TERM,
+    PROF_FLOW_TAP_TERM,
+    PROF_DEBOUNCE,
+    PROF_POINTER,
+    PROF_MATRIX_SCAN,
+    PROF_HOOK_COUNT
+};
+
+// bucket n counts calls that took 2^(n-1) to 2^n - 1 cycles
+#define PROFILE_BUCKETS 25
+
+/**
+ * Instrumentation
+ * PROFILE_BEGIN/PROFILE_END bracket a hook body; without PROFILE_ENABLE they expand to
+ * nothing, so the calls can stay in place in production builds
+ */
+#ifdef PROFILE_ENABLE
+#    include "cycles.h"
+#    define PROFILE_BEGIN(hook) uint32_t profile_start_##hook = cycles_read()
+#    define PROFILE_END(hook)   profile_add(hook, cycles_since(profile_start_##hook))
+
+void profile_init(void);
+void profile_add(uint8_t hook, uint32_t cycles);
+void profile_scan(void);
+void profile_report(void);
+#else
+#    define PROFILE_BEGIN(hook)
+#    define PROFILE_END(hook)
+#endif
@@ -0,0 +1,271 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "remap.h"
+#include "cycles.h"
+#include "eeconfig.h"
+#include "layer_index.h"
+#include "print.h"
+#include "sched.h"
+
+#define REMAP_MAGIC 0x3252 // "R2", two regions
+#define REMAP_KEYS  (LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS)
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t  generation;
+    uint8_t  count;
+    uint8_t  check;
+    uint8_t  reserved;
+} remap_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t position; // (layer * MATRIX_ROWS + row) * MATRIX_COLS + col
+    uint16_t keycode;
+} remap_entry_t;
+
+// two regions, each a header and its table; a flush writes the idle one
+#define REMAP_REGION_SIZE (REMAP_DATA_SIZE / 2)
+#define REMAP_CAPACITY    ((REMAP_REGION_SIZE - sizeof(remap_header_t)) / sizeof(remap_entry_t))
+
+_Static_assert(REMAP_REGION_SIZE > sizeof(remap_header_t), "REMAP_DATA_SIZE has no room for remapped keys");
+_Static_assert(REMAP_CAPACITY <= UINT8_MAX, "the remap count is one byte");
+
+/**
+ * Keymap in RAM
+ * Every layer of keymaps[] is copied here at boot and the stored remaps are laid over it,
+ * so a lookup is one RAM read whatever was changed. EEPROM only holds the keys that differ
+ * from the compiled-in defaults, which stay the fallback for everything else.
+ */
+static uint16_t keymap[LAYER_COUNT][MATRIX_ROWS][MATRIX_COLS];
+static bool     ready     = false;
+static uint8_t  overrides = 0;
+static uint8_t  generation;
+static uint8_t  region;
+
+static struct {
+    uint32_t edits;
+    uint32_t flushes;
+} stats;
+
+static uint16_t default_keycode(uint8_t layer, uint8_t row, uint8_t col) {
+    return keycode_at_keymap_location_raw(layer, row, col);
+}
+
+// covers the generation and the layout too, so a header torn mid-write or a table
+// written for another matrix reads as garbage
+static uint8_t table_check(const remap_entry_t *entries, uint8_t count, uint8_t gen) {
+    const uint8_t *bytes = (const uint8_t *)entries;
+    uint8_t        check = 0x5A ^ count ^ gen ^ MATRIX_ROWS ^ MATRIX_COLS << 4;
+    for (uint16_t i = 0; i < count * sizeof(remap_entry_t); i++) {
+        check = (check << 1 | check >> 7) ^ bytes[i];
+    }
+    return check;
+}
+
+static struct __attribute__((packed)) {
+    remap_header_t header;
+    remap_entry_t  entries[REMAP_CAPACITY];
+} table;
+
+static inline uint32_t region_offset(uint8_t r) {
+    return SETTINGS_DATA_SIZE + r * REMAP_REGION_SIZE;
+}
+
+// reads a region into table, true if it holds a whole table
+static bool read_region(uint8_t r) {
+    eeconfig_read_user_datablock(&table, region_offset(r), sizeof(table));
+    return table.header.magic == REMAP_MAGIC && table.header.count <= REMAP_CAPACITY && table.header.check == table_check(table.entries, table.header.count, table.header.generation);
+}
+
+void remap_init(void) {
+    for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keymap[layer][row][col] = default_keycode(layer, row, col);
+            }
+        }
+    }
+
+    // the region with the newer generation wins, generations wrap and the newer one is at
+    // most half the range ahead
+    bool    valid[2];
+    uint8_t generations[2];
+    for (uint8_t r = 0; r < 2; r++) {
+        valid[r]       = read_region(r);
+        generations[r] = table.header.generation;
+    }
+    region     = valid[1] && (!valid[0] || (int8_t)(generations[1] - generations[0]) > 0);
+    generation = valid[region] ? generations[region] : 0;
+
+    overrides = 0;
+    if (valid[region] && read_region(region)) {
+        for (uint8_t i = 0; i < table.header.count; i++) {
+            uint16_t position = table.entries[i].position;
+            if (position < REMAP_KEYS) {
+                (&keymap[0][0][0])[position] = table.entries[i].keycode;
+                overrides++;
+            }
+        }
+    }
+
+    cycles_init();
+    ready = true;
+}
+
+/**
+ * Lookups
+ * Stands in for keycode_at_keymap_location_raw through layer_index.c; before the copy is
+ * filled, reads go to flash as before
+ */
+uint16_t remap_keycode(uint8_t layer, uint8_t row, uint8_t col) {
+    if (!ready || layer >= LAYER_COUNT || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+        return default_keycode(layer, row, col);
+    }
+    return keymap[layer][row][col];
+}
+
+/**
+ * Write-back
+ * Rebuilt from the RAM copy, SETTINGS_COALESCE_MS style: the first edit opens a
+ * REMAP_FLUSH_MS window and everything edited in it lands together. The table goes to the
+ * idle region and its header last, so until the header lands boot still loads the table
+ * before, and power lost mid-flush costs at most the edits being flushed. The EEPROM
+ * driver skips unchanged bytes, so a region that already holds most of the table costs
+ * little wear.
+ */
+static uint32_t flush(void) {
+    uint8_t count = 0;
+    for (uint16_t position = 0; position < REMAP_KEYS; position++) {
+        uint8_t  layer   = position / (MATRIX_ROWS * MATRIX_COLS);
+        uint8_t  row     = position / MATRIX_COLS % MATRIX_ROWS;
+        uint8_t  col     = position % MATRIX_COLS;
+        uint16_t keycode = keymap[layer][row][col];
+        if (keycode != default_keycode(layer, row, col) && count < REMAP_CAPACITY) {
+            table.entries[count++] = (remap_entry_t){.position = position, .keycode = keycode};
+        }
+    }
+
+    uint8_t next = region ^ 1;
+    generation++;
+    table.header = (remap_header_t){.magic = REMAP_MAGIC, .generation = generation, .count = count, .check = table_check(table.entries, count, generation)};
+    eeconfig_update_user_datablock(table.entries, region_offset(next) + sizeof(remap_header_t), count * sizeof(remap_entry_t));
+    eeconfig_update_user_datablock(&table.header, region_offset(next), sizeof(remap_header_t));
+    region = next;
+    stats.flushes++;
+    return 0;
+}
+
+static void schedule_flush(void) {
+    if (!sched_is_armed(SCHED_REMAP_FLUSH)) {
+        sched_arm(SCHED_REMAP_FLUSH, REMAP_FLUSH_MS, flush);
+    }
+}
+
+static uint8_t set(uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode) {
+    if (layer >= LAYER_COUNT || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+        return REMAP_BAD_POSITION;
+    }
+
+    if (keymap[layer][row][col] == keycode) {
+        return REMAP_OK;
+    }
+
+    uint16_t fallback = default_keycode(layer, row, col);
+    bool     was      = keymap[layer][row][col] != fallback;
+    bool     is       = keycode != fallback;
+    if (is && !was && overrides >= REMAP_CAPACITY) {
+        return REMAP_FULL;
+    }
+
+    overrides += is - was;
+    keymap[layer][row][col] = keycode;
+    layer_index_update(layer, row, col);
+    stats.edits++;
+    schedule_flush();
+    return REMAP_OK;
+}
+
+static void reset(uint8_t layer) {
+    for (uint8_t l = 0; l < LAYER_COUNT; l++) {
+        if (layer != l && layer != UINT8_MAX) {
+            continue;
+        }
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                set(l, row, col, default_keycode(l, row, col));
+            }
+        }
+    }
+}
+
+/**
+ * Raw hid
+ * Byte 1 carries the status in replies, requests leave it 0:
+ * RAW_REMAP_INFO  -> layers, rows, cols, remapped keys, capacity
+ * RAW_REMAP_GET   layer, row -> layer, row, then the row's keycodes, little endian
+ * RAW_REMAP_SET   layer, row, col, keycode (little endian)
+ * RAW_REMAP_RESET layer, or 0xFF for all
+ */
+void remap_raw(uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+        case RAW_REMAP_INFO:
+            data[1] = REMAP_OK;
+            data[2] = LAYER_COUNT;
+            data[3] = MATRIX_ROWS;
+            data[4] = MATRIX_COLS;
+            data[5] = overrides;
+            data[6] = REMAP_CAPACITY;
+            break;
+        case RAW_REMAP_GET: {
+            uint8_t layer = data[2];
+            uint8_t row   = data[3];
+            if (layer >= LAYER_COUNT || row >= MATRIX_ROWS || 4 + MATRIX_COLS * 2 > length) {
+                data[1] = REMAP_BAD_POSITION;
+                break;
+            }
+            data[1] = REMAP_OK;
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                data[4 + col * 2] = keymap[layer][row][col] & 0xFF;
+                data[5 + col * 2] = keymap[layer][row][col] >> 8;
+            }
+            break;
+        }
+        case RAW_REMAP_SET:
+            data[1] = set(data[2], data[3], data[4], data[5] | data[6] << 8);
+            break;
+        case RAW_REMAP_RESET:
+            reset(data[2]);
+            data[1] = REMAP_OK;
+            break;
+    }
+}
+
+/**
+ * Lookup benchmark
+ * Cycles per keycode read, over every position of every layer: the compiled-in keymap in
+ * flash, a word from EEPROM the way the stock dynamic keymap reads each keycode, and the
+ * RAM copy. tools/bench.py picks the line up from a console capture.
+ */
+static volatile uint16_t bench_sink;
+
+static uint16_t read_eeprom(uint8_t layer, uint8_t row, uint8_t col) {
+    uint16_t keycode;
+    eeconfig_read_user_datablock(&keycode, SETTINGS_DATA_SIZE + ((layer * MATRIX_ROWS + row) * MATRIX_COLS + col) * sizeof(keycode) % REMAP_DATA_SIZE, sizeof(keycode));
+    return keycode;
+}
+
+static uint32_t bench(uint16_t (*read)(uint8_t, uint8_t, uint8_t)) {
+    uint32_t start = cycles_read();
+    for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                bench_sink = read(layer, row, col);
+            }
+        }
+    }
+    return cycles_since(start) / REMAP_KEYS;
+}
+
+void remap_report(void) {
+    uprintf("remap: %u/%u keys remapped, %lu edits, %lu flushes%s\n", overrides, (uint16_t)REMAP_CAPACITY, stats.edits, stats.flushes, sched_is_armed(SCHED_REMAP_FLUSH) ? ", flush pending" : "");
+    uprintf("remap lookup cycles: progmem %lu eeprom %lu ram %lu\n", bench(default_keycode), bench(read_eeprom), bench(remap_keycode));
+}
@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// edits are written back this long after the first one, together with any that follow
+#ifndef REMAP_FLUSH_MS
+#    define REMAP_FLUSH_MS 5000
+#endif
+
+// status byte of every remap reply, see tools/remap.py
+enum remap_status {
+    REMAP_OK,
+    REMAP_BAD_POSITION,
+    REMAP_FULL,
+};
+
+void     remap_init(void);
+uint16_t remap_keycode(uint8_t layer, uint8_t row, uint8_t col);
+void     remap_raw(uint8_t *data, uint8_t length);
+void     remap_report(void);
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "rgb_gate.h"
+#include "print.h"
+#include "profile.h"
+#include "timer.h"
+
+static bool     settling;
+static bool     asleep;
+static uint16_t settle_timer;
+static uint16_t skip_timer;
+
+static struct {
+    uint32_t flushed;
+    uint32_t skipped;
+} stats;
+
+/**
+ * Dirty frame
+ * Call after anything that changes what the LEDs should show. The task then runs for
+ * RGB_GATE_SETTLE_MS, long enough to render and flush the new frame a few times over.
+ */
+void rgb_gate_touch(void) {
+    settling     = true;
+    settle_timer = timer_read();
+}
+
+// a full frame was rendered and goes to the driver next, see rgb_matrix_indicators_advanced_user
+void rgb_gate_frame(void) {
+    stats.flushed++;
+}
+
+/**
+ * Static frames
+ * Solid color only changes through rgb_gate_touch, so once it is on the LEDs, which hold
+ * it on their own, rendering and flushing stop until the next change
+ */
+static bool gate_open(void) {
+    if (rgb_matrix_get_mode() != RGB_MATRIX_SOLID_COLOR) {
+        return true;
+    }
+
+#if defined(RGB_MATRIX_TIMEOUT) && RGB_MATRIX_TIMEOUT > 0
+    // the timeout blanks the LEDs from inside the task, so let it through on either edge
+    bool idle = last_input_activity_elapsed() > RGB_MATRIX_TIMEOUT;
+    if (idle != asleep) {
+        asleep = idle;
+        rgb_gate_touch();
+    }
+#endif
+
+    if (settling && timer_elapsed(settle_timer) >= RGB_GATE_SETTLE_MS) {
+        settling = false;
+    }
+    return settling;
+}
+
+void suspend_wakeup_init_user(void) {
+    rgb_gate_touch();
+}
+
+/**
+ * RGB matrix task
+ * Core code, so it is gated and timed by wrapping the symbol at link time (see rules.mk).
+ * While closed, every flush period that passes counts as a skipped flush.
+ */
+void __real_rgb_matrix_task(void);
+
+void __wrap_rgb_matrix_task(void) {
+    PROFILE_BEGIN(PROF_RGB_TASK);
+    if (gate_open()) {
+        __real_rgb_matrix_task();
+        skip_timer = timer_read();
+    } else if (timer_elapsed(skip_timer) >= RGB_MATRIX_LED_FLUSH_LIMIT) {
+        skip_timer = timer_read();
+        stats.skipped++;
+    }
+    PROFILE_END(PROF_RGB_TASK);
+}
+
+void rgb_gate_report(void) {
+    uprintf("rgb frames flushed %lu skipped %lu\n", stats.flushed, stats.skipped);
+}
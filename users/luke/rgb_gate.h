@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// how long the rgb matrix task keeps running after a change, a few full frames
+#ifndef RGB_GATE_SETTLE_MS
+#    define RGB_GATE_SETTLE_MS (RGB_MATRIX_LED_FLUSH_LIMIT * 4)
+#endif
+
+void rgb_gate_touch(void);
+void rgb_gate_frame(void);
+void rgb_gate_report(void);
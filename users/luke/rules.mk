@@ -0,0 +1,142 @@
+SRC += luke.c sched.c settings.c tap_hold.c indicator.c game_mode.c layer_index.c
+
+# rgb matrix task gating (no rendering or flushing while the frame is static) and timing, see rgb_gate.c
+ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
+    SRC += rgb_gate.c
+    EXTRALDFLAGS += -Wl,--wrap=rgb_matrix_task
+endif
+
+# eager press, DEBOUNCE ms deferred release, bit-sliced a row at a time, see debounce_swar.c
+SWAR_DEBOUNCE_ENABLE ?= yes
+ifeq ($(strip $(SWAR_DEBOUNCE_ENABLE)), yes)
+    DEBOUNCE_TYPE = custom
+    SRC += debounce_swar.c
+endif
+
+# combos keyed on matrix positions, only combo keys are ever held back, see combo_engine.h
+COMBO_ENGINE_ENABLE ?= no
+ifeq ($(strip $(COMBO_ENGINE_ENABLE)), yes)
+    SRC += combo_engine.c
+    OPT_DEFS += -DCOMBO_ENGINE_ENABLE
+endif
+
+# text macros streamed from housekeeping several keys per report, see MACRO_SPEC in luke.h
+MACRO_SENDER_ENABLE ?= yes
+ifeq ($(strip $(MACRO_SENDER_ENABLE)), yes)
+    SRC += macro_sender.c
+    OPT_DEFS += -DMACRO_SENDER_ENABLE
+endif
+
+# fixed point pointer with inertia steered by the NAV arrows while PTR_MOD is held, speed
+# curve in pointer_curve.h generated and simulated by tools/pointer_sim.py
+POINTER_ENABLE ?= yes
+ifeq ($(strip $(MOUSEKEY_ENABLE)), yes)
+    ifeq ($(strip $(POINTER_ENABLE)), yes)
+        SRC += pointer.c
+        OPT_DEFS += -DPOINTER_ENABLE
+    endif
+endif
+
+# scan rate governor: once idle, and further once the LEDs time out, each main loop pass
+# sleeps a millisecond or few, back to full rate on the first key, see governor.c
+GOVERNOR_ENABLE ?= yes
+ifeq ($(strip $(GOVERNOR_ENABLE)), yes)
+    SRC += governor.c
+    OPT_DEFS += -DGOVERNOR_ENABLE
+endif
+
+# runtime remapping of the five layers from tools/remap.py over raw hid, served from a RAM
+# copy of the keymap and written back to EEPROM in batches, see remap.c
+REMAP_ENABLE ?= no
+ifeq ($(strip $(REMAP_ENABLE)), yes)
+    RAW_ENABLE = yes
+    SRC += remap.c
+    OPT_DEFS += -DREMAP_ENABLE
+endif
+
+# seeded press/release streams from tools/fuzz.py pressed into the matrix and replayed
+# through the whole userspace at up to rollover rate, checked for stuck mods, keys and
+# layers and for tap-hold presses that settle other than exactly once; host reports are
+# held back while a stream runs. The hardware mode of `make fuzz`, which runs the same
+# streams natively in tests/fuzz; see tools/fuzz.py, `make fuzz-boards`
+FUZZ_ENABLE ?= no
+ifeq ($(strip $(FUZZ_ENABLE)), yes)
+    RAW_ENABLE = yes
+    SRC += fuzz.c
+    OPT_DEFS += -DFUZZ_ENABLE
+    EXTRALDFLAGS += -Wl,--wrap=host_keyboard_send -Wl,--wrap=matrix_get_row
+    ifeq ($(strip $(NKRO_ENABLE)), yes)
+        EXTRALDFLAGS += -Wl,--wrap=host_nkro_send
+    endif
+endif
+
+# per key press counts, layer dwell, WPM and same finger/hand bigrams, read over raw hid
+# with tools/analytics_collector.py
+ANALYTICS_ENABLE ?= no
+ifeq ($(strip $(ANALYTICS_ENABLE)), yes)
+    RAW_ENABLE = yes
+    SRC += analytics.c
+    OPT_DEFS += -DANALYTICS_ENABLE
+endif
+
+# which rule settled each tap-hold key and how long it took, dumped with STAT_RPT and
+# aggregated by tools/tap_decisions.py
+TAP_TELEMETRY_ENABLE ?= no
+ifeq ($(strip $(TAP_TELEMETRY_ENABLE)), yes)
+    CONSOLE_ENABLE = yes
+    SRC += tap_telemetry.c
+    OPT_DEFS += -DTAP_TELEMETRY_ENABLE
+endif
+
+# press-to-report latency histograms, printed over the console with STAT_RPT; #define
+# LATENCY_TRACE also logs every key event as a trace for tests/latency, see tests/README.md
+LATENCY_ENABLE ?= no
+ifeq ($(strip $(LATENCY_ENABLE)), yes)
+    CONSOLE_ENABLE = yes
+    SRC += latency.c
+    OPT_DEFS += -DLATENCY_ENABLE
+endif
+
+# per key home row mod tapping terms learned from typing, reset with HRM_RST
+ADAPTIVE_TERM_ENABLE ?= yes
+ifeq ($(strip $(ADAPTIVE_TERM_ENABLE)), yes)
+    SRC += adaptive_term.c
+    OPT_DEFS += -DADAPTIVE_TERM_ENABLE
+endif
+
+# home row mod letters sent on the press when the key is mostly typed as a letter, taken
+# back with a backspace if it settles as a hold, see speculative_tap.c
+SPECULATIVE_TAP_ENABLE ?= no
+ifeq ($(strip $(SPECULATIVE_TAP_ENABLE)), yes)
+    SRC += speculative_tap.c
+    OPT_DEFS += -DSPECULATIVE_TAP_ENABLE
+endif
+
+# few byte layer/brightness sync to the other half, replacing the mirrored split state
+SPLIT_SYNC_ENABLE ?= yes
+ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
+    ifeq ($(strip $(SPLIT_SYNC_ENABLE)), yes)
+        SRC += split_sync.c
+        OPT_DEFS += -DSPLIT_SYNC_ENABLE
+    endif
+endif
+
+# diagnostic: slave press to master key event latency, printed with STAT_RPT. The keymap
+# still gets the slave half from the core; the probe only fetches the slave's stamps for
+# new presses over a user transaction
+SPLIT_PROBE_ENABLE ?= no
+ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
+    ifeq ($(strip $(SPLIT_PROBE_ENABLE)), yes)
+        SRC += split_probe.c
+        OPT_DEFS += -DSPLIT_PROBE_ENABLE
+    endif
+endif
+
+# cycle histograms for the userspace hooks and the rgb matrix task, printed with STAT_RPT
+# and summarized by tools/profile_reader.py; compiles to nothing when off
+PROFILE_ENABLE ?= no
+ifeq ($(strip $(PROFILE_ENABLE)), yes)
+    CONSOLE_ENABLE = yes
+    SRC += profile.c
+    OPT_DEFS += -DPROFILE_ENABLE
+endif
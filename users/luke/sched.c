@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "sched.h"
+#include "timer.h"
+
+_Static_assert(SCHED_SLOT_COUNT <= 32, "armed slots are a 32 bit mask");
+
+static sched_callback_t callbacks[SCHED_SLOT_COUNT];
+static uint32_t         deadlines[SCHED_SLOT_COUNT];
+static uint32_t         armed    = 0;
+static uint32_t         next_due = 0;
+
+/**
+ * Arm a slot
+ * Re-arming an armed slot just moves its deadline, which is what debouncing wants.
+ * next_due only ever moves earlier here; cancel leaves it alone and the next expiry
+ * check recomputes it, so both stay O(1).
+ */
+void sched_arm(uint8_t slot, uint32_t delay_ms, sched_callback_t callback) {
+    uint32_t deadline = timer_read32() + delay_ms;
+
+    callbacks[slot] = callback;
+    deadlines[slot] = deadline;
+    if (!armed || timer_expired32(next_due, deadline)) {
+        next_due = deadline;
+    }
+    armed |= (uint32_t)1 << slot;
+}
+
+void sched_cancel(uint8_t slot) {
+    armed &= ~((uint32_t)1 << slot);
+}
+
+bool sched_is_armed(uint8_t slot) {
+    return armed & ((uint32_t)1 << slot);
+}
+
+/**
+ * Time to the next deadline
+ * For callers that sleep, so nothing armed fires late; UINT32_MAX when nothing is armed.
+ * A deadline left behind by a cancel only makes this answer early, never late.
+ */
+uint32_t sched_due_in(void) {
+    if (!armed) {
+        return UINT32_MAX;
+    }
+
+    uint32_t now = timer_read32();
+    return timer_expired32(now, next_due) ? 0 : next_due - now;
+}
+
+/**
+ * Expire due slots
+ * Called from housekeeping; the common case is a single compare against next_due
+ */
+void sched_task(void) {
+    if (!armed) {
+        return;
+    }
+
+    uint32_t now = timer_read32();
+    if (!timer_expired32(now, next_due)) {
+        return;
+    }
+
+    uint32_t pending = armed;
+    while (pending) {
+        uint8_t slot = __builtin_ctz(pending);
+        pending &= pending - 1;
+
+        if (!timer_expired32(now, deadlines[slot])) {
+            continue;
+        }
+        armed &= ~((uint32_t)1 << slot);
+
+        uint32_t again = callbacks[slot]();
+        if (again) {
+            sched_arm(slot, again, callbacks[slot]);
+        }
+    }
+
+    // recompute the earliest deadline from whatever is still armed
+    pending = armed;
+    while (pending) {
+        uint8_t slot = __builtin_ctz(pending);
+        pending &= pending - 1;
+
+        if (slot == __builtin_ctz(armed) || timer_expired32(next_due, deadlines[slot])) {
+            next_due = deadlines[slot];
+        }
+    }
+}
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Scheduler slots
+ * One fixed slot per timed feature, so arming can never fail and nothing is allocated
+ */
+enum sched_slot {
+    SCHED_SETTINGS_FLUSH,
+    SCHED_INDICATOR_SETTLE,
+    SCHED_ADAPTIVE_SAVE,
+    SCHED_COMBO_TERM,
+    SCHED_COMBO_OUTPUT,
+    SCHED_REMAP_FLUSH,
+    SCHED_SLOT_COUNT
+};
+
+// return 0 to finish, or a delay in ms to run again
+typedef uint32_t (*sched_callback_t)(void);
+
+void sched_arm(uint8_t slot, uint32_t delay_ms, sched_callback_t callback);
+void sched_cancel(uint8_t slot);
+bool sched_is_armed(uint8_t slot);
+uint32_t sched_due_in(void);
+void sched_task(void);
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "settings.h"
+#include "eeconfig.h"
+#include "print.h"
+#include "sched.h"
+
+#define SETTINGS_MAGIC 0x4C4A // "JL"
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t  generation;
+    uint8_t  reserved;
+} journal_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  tag; // setting id, low generation bits above it
+    uint8_t  check;
+    uint16_t writes;
+    uint32_t value;
+} journal_record_t;
+
+// two regions, each a header and its journal; compaction writes the idle one
+#define JOURNAL_REGION_SIZE (SETTINGS_DATA_SIZE / 2)
+#define JOURNAL_RECORDS     ((JOURNAL_REGION_SIZE - sizeof(journal_header_t)) / sizeof(journal_record_t))
+
+_Static_assert(JOURNAL_RECORDS >= SETTING_ID_COUNT * 2, "SETTINGS_DATA_SIZE is too small for the settings journal");
+_Static_assert(SETTING_ID_COUNT <= 32, "dirty and present settings are 32 bit masks");
+
+#define RECORD_ID_BITS 5
+#define RECORD_ID_MASK ((1 << RECORD_ID_BITS) - 1)
+
+static uint32_t values[SETTING_ID_COUNT];
+static uint16_t writes[SETTING_ID_COUNT];
+static uint32_t present = 0;
+static uint32_t dirty   = 0;
+static uint8_t  generation;
+static uint8_t  region;
+static uint16_t tail;
+
+// the generation bits in the tag tell records left over from before a compaction apart;
+// CRC-8 over the rest catches records half overwritten when power went mid-write
+static inline uint8_t record_tag(uint8_t id) {
+    return id | (uint8_t)(generation << RECORD_ID_BITS);
+}
+
+static uint8_t record_check(const journal_record_t *rec) {
+    const uint8_t *bytes = (const uint8_t *)rec;
+    uint8_t        check = 0xFF;
+    for (uint8_t i = 0; i < sizeof(*rec); i++) {
+        if (i == offsetof(journal_record_t, check)) {
+            continue;
+        }
+        check ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            check = check & 0x80 ? (uint8_t)(check << 1) ^ 0x07 : (uint8_t)(check << 1);
+        }
+    }
+    return check;
+}
+
+static inline uint32_t record_offset(uint8_t r, uint16_t slot) {
+    return r * JOURNAL_REGION_SIZE + sizeof(journal_header_t) + slot * sizeof(journal_record_t);
+}
+
+static void write_header(uint8_t r) {
+    journal_header_t header = {.magic = SETTINGS_MAGIC, .generation = generation};
+    eeconfig_update_user_datablock(&header, r * JOURNAL_REGION_SIZE, sizeof(header));
+}
+
+static void write_record(uint8_t r, uint16_t slot, uint8_t id) {
+    journal_record_t rec = {.tag = record_tag(id), .writes = writes[id], .value = values[id]};
+    rec.check            = record_check(&rec);
+    eeconfig_update_user_datablock(&rec, record_offset(r, slot), sizeof(rec));
+}
+
+static void append(uint8_t id) {
+    write_record(region, tail++, id);
+}
+
+/**
+ * Compaction
+ * Once the journal is full, start a new generation holding one record per setting in the
+ * other region. Its header goes last: until that lands, boot still replays the old region,
+ * so losing power halfway through costs at most the writes being flushed.
+ */
+static void compact(void) {
+    uint8_t next = region ^ 1;
+
+    generation++;
+    tail = 0;
+    for (uint8_t id = 1; id < SETTING_ID_COUNT; id++) {
+        if (present & ((uint32_t)1 << id)) {
+            write_record(next, tail++, id);
+        }
+    }
+    write_header(next);
+    region = next;
+}
+
+/**
+ * Boot replay
+ * The region with the newer generation is replayed oldest to newest a record at a time,
+ * so the latest record of each setting wins and tail ends up at the first unused slot
+ */
+void settings_init(void) {
+    journal_header_t headers[2];
+    for (uint8_t r = 0; r < 2; r++) {
+        eeconfig_read_user_datablock(&headers[r], r * JOURNAL_REGION_SIZE, sizeof(journal_header_t));
+    }
+
+    bool valid[2] = {headers[0].magic == SETTINGS_MAGIC, headers[1].magic == SETTINGS_MAGIC};
+    if (!valid[0] && !valid[1]) {
+        generation = 0;
+        region     = 0;
+        tail       = 0;
+        write_header(region);
+        return;
+    }
+
+    // generations wrap, the newer one is at most half the range ahead
+    region     = valid[1] && (!valid[0] || (int8_t)(headers[1].generation - headers[0].generation) > 0);
+    generation = headers[region].generation;
+    for (tail = 0; tail < JOURNAL_RECORDS; tail++) {
+        journal_record_t rec;
+        eeconfig_read_user_datablock(&rec, record_offset(region, tail), sizeof(rec));
+        uint8_t id = rec.tag & RECORD_ID_MASK;
+        if (id == SETTING_NONE || id >= SETTING_ID_COUNT || rec.tag != record_tag(id) || rec.check != record_check(&rec)) {
+            break;
+        }
+        values[id] = rec.value;
+        writes[id] = rec.writes;
+        present |= (uint32_t)1 << id;
+    }
+}
+
+bool settings_get(uint8_t id, uint32_t *value) {
+    if (id >= SETTING_ID_COUNT || !(present & ((uint32_t)1 << id))) {
+        return false;
+    }
+    *value = values[id];
+    return true;
+}
+
+uint32_t settings_get_or(uint8_t id, uint32_t fallback) {
+    settings_get(id, &fallback);
+    return fallback;
+}
+
+static uint32_t flush(void) {
+    uint32_t pending = dirty;
+    while (pending) {
+        writes[__builtin_ctz(pending)]++;
+        pending &= pending - 1;
+    }
+
+    // compaction rewrites every present setting, the dirty ones included
+    uint16_t needed = tail + __builtin_popcount(dirty);
+    if (needed > JOURNAL_RECORDS) {
+        compact();
+    } else {
+        while (dirty) {
+            append(__builtin_ctz(dirty));
+            dirty &= dirty - 1;
+        }
+    }
+
+    dirty = 0;
+    return 0;
+}
+
+/**
+ * Updates
+ * Only the RAM copy changes here; the first change opens a SETTINGS_COALESCE_MS window
+ * and everything dirty at its end is appended once
+ */
+void settings_set(uint8_t id, uint32_t value) {
+    if (id == SETTING_NONE || id >= SETTING_ID_COUNT) {
+        return;
+    }
+
+    uint32_t bit = (uint32_t)1 << id;
+    if ((present & bit) && values[id] == value) {
+        return;
+    }
+
+    values[id] = value;
+    present |= bit;
+    dirty |= bit;
+    if (!sched_is_armed(SCHED_SETTINGS_FLUSH)) {
+        sched_arm(SCHED_SETTINGS_FLUSH, SETTINGS_COALESCE_MS, flush);
+    }
+}
+
+void settings_report(void) {
+    uprintf("settings: generation %u in region %u, %u/%u records used, writes:", generation, region, tail, (uint16_t)JOURNAL_RECORDS);
+    for (uint8_t id = 1; id < SETTING_ID_COUNT; id++) {
+        uprintf(" %u", writes[id]);
+    }
+    uprintf("\n");
+}
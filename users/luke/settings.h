@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// writes to the same setting within this window are merged into one journal record
+#ifndef SETTINGS_COALESCE_MS
+#    define SETTINGS_COALESCE_MS 3000
+#endif
+
+enum setting_id {
+    SETTING_NONE,
+    SETTING_BRIGHTNESS,  // rgb matrix value
+    SETTING_HRM_TERMS,   // adaptive_term.c 4 bit steps
+    SETTING_LAYER_COLOR, // hue << 8 | sat, one per layer
+    SETTING_LAYER_COLOR_LAST = SETTING_LAYER_COLOR + NUM,
+    SETTING_ID_COUNT
+};
+
+void     settings_init(void);
+bool     settings_get(uint8_t id, uint32_t *value);
+uint32_t settings_get_or(uint8_t id, uint32_t fallback);
+void     settings_set(uint8_t id, uint32_t value);
+void     settings_report(void);
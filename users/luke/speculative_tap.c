@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "speculative_tap.h"
+#include "game_mode.h"
+#include "print.h"
+#include "timer.h"
+
+#ifndef FLOW_TAP_TERM
+#    define FLOW_TAP_TERM 0
+#endif
+
+/**
+ * Outcomes
+ * Per key count of presses that came out as the letter, real taps plus lone holds that
+ * retro tapping turned back into it, against presses used as a modifier. Counts saturate
+ * at 255 and then both halve, so the share follows how the key is used lately.
+ */
+typedef struct {
+    uint8_t taps;
+    uint8_t holds;
+} outcome_t;
+
+static const uint16_t confidence[HRM_SLOTS] = SPECULATIVE_TAP_CONFIDENCE;
+
+static outcome_t outcomes[HRM_SLOTS];
+static uint8_t   speculated;  // slots whose letter is already out
+static uint8_t   held;        // slots down and not yet released through the core
+static uint8_t   interrupted; // slots that saw another press while down
+static uint8_t   released;    // slots with a release time below
+static uint16_t  release_time[HRM_SLOTS];
+static uint16_t  last_time;
+static bool      last_valid = false;
+
+static speculative_tap_stats_t stats;
+
+// anything else down means a chord may be forming, where the modifier is what is wanted
+static bool others_down(keypos_t key) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t bits = matrix_get_row(row);
+        if (row == key.row) {
+            bits &= ~((matrix_row_t)1 << key.col);
+        }
+        if (bits) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool likely_tap(uint16_t keycode, uint8_t slot, keyrecord_t *record) {
+    if (game_mode_is_active() || get_mods() || get_oneshot_mods() || !last_valid || others_down(record->event.key)) {
+        return false;
+    }
+
+    // flow taps are settled by the core on the press already, so there is nothing to win
+    uint16_t since = TIMER_DIFF_16(record->event.time, last_time);
+    if (since < FLOW_TAP_TERM || since > SPECULATIVE_TAP_STREAK_MS) {
+        return false;
+    }
+    // and so are quick tap repeats, timed like the core does from the key's last release;
+    // a repeat must stay registered while held
+    if ((released & (1 << slot)) && TIMER_DIFF_16(record->event.time, release_time[slot]) < get_quick_tap_term(keycode, record)) {
+        return false;
+    }
+
+    uint16_t total = outcomes[slot].taps + outcomes[slot].holds;
+    return total >= SPECULATIVE_TAP_MIN_SAMPLES && (uint32_t)outcomes[slot].taps * 1000 >= (uint32_t)confidence[slot] * total;
+}
+
+static void add_outcome(uint8_t slot, bool tap) {
+    outcome_t *key   = &outcomes[slot];
+    uint8_t   *count = tap ? &key->taps : &key->holds;
+    if (*count == UINT8_MAX) {
+        key->taps >>= 1;
+        key->holds >>= 1;
+    }
+    (*count)++;
+}
+
+/**
+ * Raw events
+ * Ahead of the tap-hold machinery, so a likely tap can go out on the press before the core
+ * has settled it. Nothing else is down, so the core holds back no earlier key that the
+ * letter could overtake. Releases only note the time for the quick tap check.
+ */
+void speculative_tap_event(uint16_t keycode, keyrecord_t *record) {
+    if (record->event.type != KEY_EVENT) {
+        return;
+    }
+
+    uint8_t slot = tap_hold_slot(keycode, record);
+    uint8_t bit  = slot < HRM_SLOTS ? 1 << slot : 0;
+    if (!record->event.pressed) {
+        if (bit) {
+            release_time[slot] = record->event.time;
+            released |= bit;
+        }
+        return;
+    }
+    interrupted |= held;
+
+    if (bit) {
+        if (likely_tap(keycode, slot, record)) {
+            tap_code(QK_MOD_TAP_GET_TAP_KEYCODE(keycode));
+            speculated |= bit;
+            stats.speculations++;
+        }
+        held |= bit;
+        interrupted &= ~bit;
+    }
+
+    last_time  = record->event.time;
+    last_valid = true;
+}
+
+/**
+ * Settled events
+ * A tap for a key that already went out is swallowed, press and release. A hold takes the
+ * letter back with a backspace before the modifier goes down, so the text comes out the
+ * same as without speculation. Returns false for swallowed events.
+ */
+bool speculative_tap_process(uint16_t keycode, keyrecord_t *record) {
+    uint8_t slot = tap_hold_slot(keycode, record);
+    if (slot >= HRM_SLOTS || record->event.type != KEY_EVENT) {
+        return true;
+    }
+    uint8_t bit = 1 << slot;
+
+    if (record->event.pressed) {
+        if (!(speculated & bit)) {
+            return true;
+        }
+        if (record->tap.count) {
+            stats.hits++;
+            return false;
+        }
+        tap_code(KC_BSPC);
+        speculated &= ~bit;
+        stats.rollbacks++;
+        return true;
+    }
+
+    if ((held & bit) && !game_mode_is_active()) {
+        add_outcome(slot, record->tap.count || !(interrupted & bit));
+    }
+    held &= ~bit;
+    interrupted &= ~bit;
+
+    if (speculated & bit) {
+        speculated &= ~bit;
+        return false;
+    }
+    return true;
+}
+
+const speculative_tap_stats_t *speculative_tap_stats(void) {
+    return &stats;
+}
+
+void speculative_tap_report(void) {
+    uprintf("speculative taps: %lu sent, %lu hits, %lu rolled back\n", stats.speculations, stats.hits, stats.rollbacks);
+    uprintf("letter share permille:");
+    for (uint8_t slot = 0; slot < HRM_SLOTS; slot++) {
+        uint16_t total = outcomes[slot].taps + outcomes[slot].holds;
+        uprintf(" %u", total ? (uint16_t)((uint32_t)outcomes[slot].taps * 1000 / total) : 0);
+    }
+    uprintf("\n");
+}
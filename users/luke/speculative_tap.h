@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "tap_hold.h"
+
+// per key share of presses that came out as the letter before the key speculates, in
+// permille and home row mod slot order (A R S T N E I O); the shifts are used as holds
+// mid-sentence and start higher
+#ifndef SPECULATIVE_TAP_CONFIDENCE
+#    define SPECULATIVE_TAP_CONFIDENCE {950, 950, 950, 980, 980, 950, 950, 950}
+#endif
+
+// presses a key needs on record before its share is trusted
+#ifndef SPECULATIVE_TAP_MIN_SAMPLES
+#    define SPECULATIVE_TAP_MIN_SAMPLES 32
+#endif
+
+// only speculate mid-typing, within this long of the previous press
+#ifndef SPECULATIVE_TAP_STREAK_MS
+#    define SPECULATIVE_TAP_STREAK_MS 1000
+#endif
+
+typedef struct {
+    uint32_t speculations;
+    uint32_t hits;
+    uint32_t rollbacks;
+} speculative_tap_stats_t;
+
+void speculative_tap_event(uint16_t keycode, keyrecord_t *record);
+bool speculative_tap_process(uint16_t keycode, keyrecord_t *record);
+void speculative_tap_report(void);
+
+const speculative_tap_stats_t *speculative_tap_stats(void);
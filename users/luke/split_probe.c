@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "split_probe.h"
+#include <string.h>
+#include "fuzz.h"
+#include "matrix.h"
+#include "print.h"
+#include "sync_timer.h"
+#include "timer.h"
+#include "transactions.h"
+
+typedef struct {
+    uint32_t fetches;
+    uint32_t failures;
+    uint32_t bytes;
+    uint32_t presses;
+    uint16_t max_ms;
+    uint16_t buckets[SPLIT_PROBE_BUCKETS];
+} split_probe_stats_t;
+
+// slave side: when each key of the half was last pressed
+static matrix_row_t slave_rows[SPLIT_PROBE_ROWS];
+static uint16_t     slave_stamps[SPLIT_PROBE_ROWS][MATRIX_COLS];
+
+// master side: the slave half as the core delivered it, and the presses with a stamp
+static matrix_row_t core_rows[SPLIT_PROBE_ROWS];
+static matrix_row_t stamped[SPLIT_PROBE_ROWS];
+static uint16_t     stamps[SPLIT_PROBE_ROWS][MATRIX_COLS];
+static uint32_t     stats_timer = 0;
+
+static split_probe_stats_t stats;
+
+static uint8_t local_offset(void) {
+    return is_keyboard_left() ? 0 : SPLIT_PROBE_ROWS;
+}
+
+static uint8_t remote_offset(void) {
+    return is_keyboard_left() ? SPLIT_PROBE_ROWS : 0;
+}
+
+/**
+ * Slave scan
+ * Stamps every press on the timer the master keeps the halves synced to
+ */
+void split_probe_slave_scan(void) {
+    uint16_t now = sync_timer_read();
+    for (uint8_t r = 0; r < SPLIT_PROBE_ROWS; r++) {
+        matrix_row_t row     = matrix_get_row(local_offset() + r);
+        matrix_row_t pressed = row & ~slave_rows[r];
+        for (uint8_t col = 0; pressed >> col; col++) {
+            if (pressed >> col & 1) {
+                slave_stamps[r][col] = now;
+            }
+        }
+        slave_rows[r] = row;
+    }
+}
+
+/**
+ * Slave side
+ * Answers with the stamps of the presses the master asks for, the first
+ * SPLIT_PROBE_MAX_PRESSES of them
+ */
+static void split_probe_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    const split_probe_req_t *req   = in_data;
+    split_probe_reply_t     *reply = out_data;
+    if (in_buflen != sizeof(*req) || out_buflen != sizeof(*reply)) {
+        return;
+    }
+
+    uint8_t count = 0;
+    for (uint8_t r = 0; r < SPLIT_PROBE_ROWS; r++) {
+        for (uint8_t col = 0; req->want[r] >> col && count < SPLIT_PROBE_MAX_PRESSES; col++) {
+            if (req->want[r] >> col & 1) {
+                reply->stamps[count++] = slave_stamps[r][col];
+            }
+        }
+    }
+    reply->count = count;
+}
+
+// stamps the first presses in want and takes them out of it, false when the link failed
+static bool fetch(matrix_row_t *want) {
+    split_probe_req_t   req;
+    split_probe_reply_t reply;
+    memcpy(req.want, want, sizeof(req.want));
+
+    stats.fetches++;
+    if (!transaction_rpc_exec(USER_SPLIT_PROBE, sizeof(req), &req, sizeof(reply), &reply) || reply.count > SPLIT_PROBE_MAX_PRESSES) {
+        stats.failures++;
+        return false;
+    }
+    stats.bytes += sizeof(req) + 1 + reply.count * sizeof(uint16_t);
+
+    // the same walk as the handler's, so the stamps line up with the positions
+    uint8_t i = 0;
+    for (uint8_t r = 0; r < SPLIT_PROBE_ROWS; r++) {
+        for (uint8_t col = 0; req.want[r] >> col && i < reply.count; col++) {
+            matrix_row_t bit = (matrix_row_t)1 << col;
+            if (req.want[r] & bit) {
+                stamps[r][col] = reply.stamps[i++];
+                want[r] &= ~bit;
+                stamped[r] |= bit;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Master scan
+ * Called from matrix_scan_user, after the core has read the slave half and before it
+ * turns the rows into key events. The keymap only ever sees the core's rows; the probe
+ * asks the slave for stamps when they show new presses and otherwise puts nothing on the
+ * link. The events follow in the same scan, so a press whose fetch failed goes untimed
+ * rather than asked again.
+ */
+void split_probe_scan(void) {
+    if (!is_keyboard_master()) {
+        return;
+    }
+
+    matrix_row_t want[SPLIT_PROBE_ROWS];
+    bool         any = false;
+    for (uint8_t r = 0; r < SPLIT_PROBE_ROWS; r++) {
+        matrix_row_t row = matrix_get_row(remote_offset() + r);
+        // a fuzz stream's keys are in the rows the core sees but were never on the slave
+        want[r]      = fuzz_running() ? 0 : row & ~core_rows[r];
+        stamped[r]  &= row;
+        core_rows[r] = row;
+        any |= want[r];
+    }
+    while (any && fetch(want)) {
+        any = false;
+        for (uint8_t r = 0; r < SPLIT_PROBE_ROWS; r++) {
+            any |= want[r];
+        }
+    }
+}
+
+void split_probe_init(void) {
+    transaction_register_rpc(USER_SPLIT_PROBE, split_probe_handler);
+    stats_timer = timer_read32();
+}
+
+/**
+ * Latency probe
+ * Slave press to master key event: the slave's stamp against the event time the master
+ * gave the press, both on the master's clock through the synced timer
+ */
+void split_probe_event(keyrecord_t *record) {
+    if (!is_keyboard_master() || !record->event.pressed || record->event.type != KEY_EVENT) {
+        return;
+    }
+
+    uint8_t      r   = record->event.key.row - remote_offset();
+    uint8_t      col = record->event.key.col;
+    matrix_row_t bit = (matrix_row_t)1 << col;
+    if (r >= SPLIT_PROBE_ROWS || col >= MATRIX_COLS || !(stamped[r] & bit)) {
+        return;
+    }
+    stamped[r] &= ~bit;
+
+    // a stamp ahead of the event is clock skew from a resync, count it as no delay
+    uint16_t delay  = TIMER_DIFF_16(record->event.time, stamps[r][col]);
+    delay           = delay > UINT16_MAX / 2 ? 0 : delay;
+    uint8_t  bucket = delay < SPLIT_PROBE_BUCKETS ? delay : SPLIT_PROBE_BUCKETS - 1;
+
+    if (stats.buckets[bucket] < UINT16_MAX) {
+        stats.buckets[bucket]++;
+    }
+    stats.presses++;
+    if (delay > stats.max_ms) {
+        stats.max_ms = delay;
+    }
+}
+
+// upper edge of the bucket holding the given percentile, 0 when empty
+static uint8_t probe_percentile(uint8_t percent) {
+    uint32_t target = (stats.presses * percent + 99) / 100;
+    uint32_t seen   = 0;
+    for (uint8_t i = 0; i < SPLIT_PROBE_BUCKETS; i++) {
+        seen += stats.buckets[i];
+        if (seen && seen >= target) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+void split_probe_report(void) {
+    uint32_t secs = timer_elapsed32(stats_timer) / 1000;
+    if (!secs) {
+        secs = 1;
+    }
+
+    uprintf("split probe: %lu fetches (%lu failed), %lu B/s\n", stats.fetches, stats.failures, stats.bytes / secs);
+    uprintf("slave press to master event: %lu presses, p50 %u ms, p99 %u ms, max %u ms\n", stats.presses, probe_percentile(50), probe_percentile(99), stats.max_ms);
+}
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+#define SPLIT_PROBE_ROWS (MATRIX_ROWS / 2)
+
+// presses stamped in one fetch, the rest wait for the next scan
+#define SPLIT_PROBE_MAX_PRESSES 8
+
+// probe resolution: 1 ms buckets, the sync timer has no finer grain
+#define SPLIT_PROBE_BUCKETS 32
+
+typedef struct __attribute__((packed)) {
+    matrix_row_t want[SPLIT_PROBE_ROWS]; // presses the master has no stamp for yet
+} split_probe_req_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  count;                           // stamps filled, the first wanted positions in row and column order
+    uint16_t stamps[SPLIT_PROBE_MAX_PRESSES]; // slave sync timer at the key's last press
+} split_probe_reply_t;
+
+void split_probe_init(void);
+void split_probe_slave_scan(void);
+void split_probe_scan(void);
+void split_probe_event(keyrecord_t *record);
+void split_probe_report(void);
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "split_sync.h"
+#include "indicator.h"
+#ifdef GOVERNOR_ENABLE
+#    include "governor.h"
+#endif
+#include "transactions.h"
+#include "print.h"
+#include "timer_us.h"
+
+static split_sync_msg_t   sent;
+static bool               sent_valid = false;
+static uint32_t           sent_timer = 0;
+static uint32_t           stats_timer = 0;
+static split_sync_stats_t stats;
+
+/**
+ * Slave side
+ * Versioned so a half flashed with a different layout ignores what it cannot read,
+ * and sequenced so the periodic resync does not repaint an unchanged frame
+ */
+static void split_sync_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    static uint8_t last_seq = 0;
+    static bool    synced   = false;
+
+    const split_sync_msg_t *msg = in_data;
+    if (in_buflen != sizeof(*msg) || msg->version != SPLIT_SYNC_VERSION) {
+        return;
+    }
+    if (synced && msg->seq == last_seq) {
+        return;
+    }
+
+    last_seq = msg->seq;
+    synced   = true;
+    indicator_sync(msg->layer, msg->val);
+#ifdef GOVERNOR_ENABLE
+    governor_sync(msg->governor);
+#endif
+}
+
+void split_sync_init(void) {
+    transaction_register_rpc(USER_SPLIT_SYNC, split_sync_handler);
+    stats_timer = timer_read32();
+}
+
+/**
+ * Master side
+ * Sends the few bytes the slave needs only when the shown layer, the brightness or the
+ * scan governor state changes, instead of mirroring matrix, layer and LED state across
+ * the link every cycle
+ */
+void split_sync_task(void) {
+    if (!is_keyboard_master()) {
+        return;
+    }
+
+    split_sync_msg_t msg = {
+        .version  = SPLIT_SYNC_VERSION,
+        .seq      = sent.seq,
+        .layer    = indicator_layer(),
+        .val      = indicator_brightness(),
+#ifdef GOVERNOR_ENABLE
+        .governor = governor_state(),
+#endif
+    };
+
+    bool changed = !sent_valid || msg.layer != sent.layer || msg.val != sent.val || msg.governor != sent.governor;
+    if (!changed && timer_elapsed32(sent_timer) < SPLIT_SYNC_RESYNC_MS) {
+        return;
+    }
+    if (changed) {
+        msg.seq++;
+    }
+
+    uint32_t start = timer_read_us();
+    bool     ok    = transaction_rpc_send(USER_SPLIT_SYNC, sizeof(msg), &msg);
+    uint32_t took  = timer_elapsed_us(start);
+
+    stats.transactions++;
+    stats.bytes += sizeof(msg);
+    stats.busy_us += took;
+    if (took > stats.max_us) {
+        stats.max_us = took;
+    }
+
+    // a failed send keeps the old state so the next scan retries
+    if (!ok) {
+        stats.failures++;
+        return;
+    }
+    sent       = msg;
+    sent_valid = true;
+    sent_timer = timer_read32();
+}
+
+void split_sync_report(void) {
+    uint32_t secs = timer_elapsed32(stats_timer) / 1000;
+    if (!secs) {
+        secs = 1;
+    }
+
+    uprintf("split sync: %lu tx (%lu failed), %lu B/s, link busy %lu us/s, max %lu us\n", stats.transactions, stats.failures, stats.bytes / secs, stats.busy_us / secs, stats.max_us);
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+#define SPLIT_SYNC_VERSION 2
+
+// the master re-sends unchanged state this often, in case the other half was reset
+#ifndef SPLIT_SYNC_RESYNC_MS
+#    define SPLIT_SYNC_RESYNC_MS 5000
+#endif
+
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t seq;
+    uint8_t layer;
+    uint8_t val;
+    uint8_t governor;
+} split_sync_msg_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t failures;
+    uint32_t bytes;
+    uint32_t busy_us;
+    uint32_t max_us;
+} split_sync_stats_t;
+
+void split_sync_init(void);
+void split_sync_task(void);
+void split_sync_report(void);
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "tap_hold.h"
+#include "game_mode.h"
+#include "tap_telemetry.h"
+#include "profile.h"
+#ifdef ADAPTIVE_TERM_ENABLE
+#    include "adaptive_term.h"
+#endif
+
+/**
+ * Entry lookup
+ * One flash read at the key's matrix position; the stored keycode guards against a
+ * different tap-hold key resolving from another layer, or a key with no matrix position
+ */
+uint32_t tap_hold_entry(uint16_t keycode, keyrecord_t *record) {
+    keypos_t key = record->event.key;
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return 0;
+    }
+
+    uint32_t entry = pgm_read_dword(&tap_hold_table[key.row][key.col]);
+    return (uint16_t)entry == keycode ? entry : 0;
+}
+
+/**
+ * Tapping Term
+ * Maximum time between key press and release to be considered a tap
+ */
+static uint16_t tapping_term(uint16_t keycode, keyrecord_t *record) {
+    if (game_mode_is_active()) {
+        return GAME_TAPPING_TERM;
+    }
+#ifdef ADAPTIVE_TERM_ENABLE
+    uint8_t slot = tap_hold_slot(keycode, record);
+    if (slot < HRM_SLOTS) {
+        return adaptive_term_get(slot);
+    }
+#endif
+    return tap_hold_flags(keycode, record) & TH_HRM_TERM ? HRM_TAPPING_TERM : TAPPING_TERM;
+}
+
+/**
+ * Quick Tap Term
+ * Time to treat a tap-hold key as a tap if a second key is pressed quickly after it
+ * Enables tap-repeat and prevents accidental holds
+ */
+static uint16_t quick_tap_term(uint16_t keycode, keyrecord_t *record) {
+    if (game_mode_is_active()) {
+        return 0;
+    }
+    return tap_hold_flags(keycode, record) & TH_QUICK_TAP ? TAPPING_TERM : 0;
+}
+
+/**
+ * Flow Tap
+ * biases tap-hold keys toward tap (and enables auto-repeat) if pressed right after another key
+ */
+static uint16_t flow_tap_term(uint16_t keycode, keyrecord_t *record) {
+    if (game_mode_is_active()) {
+        return 0;
+    }
+    uint16_t term = tap_hold_flags(keycode, record) & TH_NO_FLOW ? 0 : FLOW_TAP_TERM;
+    TAP_NOTE_FLOW(term, record);
+    return term;
+}
+
+/**
+ * Term callbacks
+ * The core asks for these on every tap-hold event, so they are profiled one by one
+ */
+uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
+    PROFILE_BEGIN(PROF_TAPPING_TERM);
+    uint16_t term = tapping_term(keycode, record);
+    PROFILE_END(PROF_TAPPING_TERM);
+    return term;
+}
+
+uint16_t get_quick_tap_term(uint16_t keycode, keyrecord_t *record) {
+    PROFILE_BEGIN(PROF_QUICK_TAP_TERM);
+    uint16_t term = quick_tap_term(keycode, record);
+    PROFILE_END(PROF_QUICK_TAP_TERM);
+    return term;
+}
+
+uint16_t get_flow_tap_term(uint16_t keycode, keyrecord_t *record, uint16_t prev_keycode) {
+    PROFILE_BEGIN(PROF_FLOW_TAP_TERM);
+    uint16_t term = flow_tap_term(keycode, record);
+    PROFILE_END(PROF_FLOW_TAP_TERM);
+    return term;
+}
+
+/**
+ * Permissive Hold
+ * Favor hold when another key is pressed during the tapping term
+ */
+bool get_permissive_hold(uint16_t keycode, keyrecord_t *record) {
+    if (game_mode_is_active()) {
+        return false;
+    }
+    bool hold = tap_hold_flags(keycode, record) & TH_PERMISSIVE;
+    if (hold) {
+        TAP_NOTE(TAP_RULE_PERMISSIVE, record, NULL);
+    }
+    return hold;
+}
+
+/**
+ * Retro Tapping
+ * Wait until a key is released to determine if it should be a tap or hold action
+ */
+bool get_retro_tapping(uint16_t keycode, keyrecord_t *record) {
+    if (game_mode_is_active()) {
+        return false;
+    }
+    return tap_hold_flags(keycode, record) & TH_RETRO;
+}
+
+/**
+ * Hold On Other Key Press
+ * Resolve as hold as soon as another key is pressed, without waiting for its release
+ */
+bool get_hold_on_other_key_press(uint16_t keycode, keyrecord_t *record) {
+    bool hold = game_mode_is_active() || tap_hold_flags(keycode, record) & TH_HOLD_OTHER;
+    if (hold) {
+        TAP_NOTE(TAP_RULE_HOLD_OTHER, record, NULL);
+    }
+    return hold;
+}
+
+/**
+ * Chordal Hold
+ * Same hand chords settle as taps while typing; in GAME any chord is a hold
+ */
+bool get_chordal_hold(uint16_t tap_hold_keycode, keyrecord_t *tap_hold_record, uint16_t other_keycode, keyrecord_t *other_record) {
+    if (game_mode_is_active()) {
+        return true;
+    }
+    bool hold = get_chordal_hold_default(tap_hold_record, other_record);
+    if (!hold) {
+        TAP_NOTE(TAP_RULE_CHORDAL, tap_hold_record, other_record);
+    }
+    return hold;
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+#include "map_macro.h"
+
+#ifndef HRM_TAPPING_TERM
+#    define HRM_TAPPING_TERM (TAPPING_TERM + 100)
+#endif
+
+/**
+ * Tap-hold flags
+ * Packed into the upper half of each tap_hold_table entry
+ */
+#define TH_HRM_TERM   (1 << 0) // use HRM_TAPPING_TERM instead of TAPPING_TERM
+#define TH_QUICK_TAP  (1 << 1) // quick tap term of TAPPING_TERM instead of 0
+#define TH_PERMISSIVE (1 << 2) // permissive hold
+#define TH_RETRO      (1 << 3) // retro tapping
+#define TH_HOLD_OTHER (1 << 4) // hold on other key press
+#define TH_NO_FLOW    (1 << 5) // flow tap term of 0 instead of FLOW_TAP_TERM
+
+#define TH_HOME_ROW_MOD (TH_HRM_TERM | TH_QUICK_TAP | TH_RETRO)
+#define TH_THUMB_LAYER  (TH_QUICK_TAP | TH_PERMISSIVE | TH_NO_FLOW)
+
+/**
+ * Tap-hold spec
+ * The single source of truth for per-key tap-hold behavior, keyed on the same aliases the
+ * keymap uses. Keys not listed here get the plain TAPPING_TERM/FLOW_TAP_TERM defaults.
+ * The slot column numbers the home row mods 1-8 for per-key runtime state, 0 for none.
+ */
+#define TAP_HOLD_SPEC(X, k)                   \
+    X(k, HRM_A,    TH_HOME_ROW_MOD, 1)        \
+    X(k, HRM_R,    TH_HOME_ROW_MOD, 2)        \
+    X(k, HRM_S,    TH_HOME_ROW_MOD, 3)        \
+    X(k, HRM_T,    TH_HOME_ROW_MOD, 4)        \
+    X(k, HRM_N,    TH_HOME_ROW_MOD, 5)        \
+    X(k, HRM_E,    TH_HOME_ROW_MOD, 6)        \
+    X(k, HRM_I,    TH_HOME_ROW_MOD, 7)        \
+    X(k, HRM_O,    TH_HOME_ROW_MOD, 8)        \
+    X(k, NAV_BS,   TH_THUMB_LAYER,  0)        \
+    X(k, NAV_SPC,  TH_THUMB_LAYER,  0)        \
+    X(k, NUM_ENT,  TH_NO_FLOW,      0)        \
+    X(k, SYS_ESC,  0,               0)        \
+    X(k, SYS_QUOT, 0,               0)
+
+#define HRM_SLOTS 8
+
+// entry layout: keycode in bits 0-15, TH_* flags in bits 16-23, slot in bits 24-31, 0 for keys outside the spec
+#define TAP_HOLD_MATCH(k, alias, flags, slot) ((k) == (alias)) ? ((uint32_t)(slot) << 24 | (uint32_t)(flags) << 16 | (uint16_t)(alias)) :
+#define TAP_HOLD_ENTRY(k)                     (TAP_HOLD_SPEC(TAP_HOLD_MATCH, k) 0)
+
+/**
+ * Generates tap_hold_table from a keymap layer macro, laid out through the board's LAYOUT()
+ * so it is indexed by matrix position exactly like keymaps[]. Tap-hold keys on other layers
+ * must sit where this layer has the same key, which holds for every layer we have today;
+ * anything else falls back to the defaults instead of picking up the wrong flags.
+ */
+#define TAP_HOLD_TABLE(...) const uint32_t PROGMEM tap_hold_table[MATRIX_ROWS][MATRIX_COLS] = LAYOUT_wrapper(MAP_LIST(TAP_HOLD_ENTRY, __VA_ARGS__))
+
+extern const uint32_t PROGMEM tap_hold_table[MATRIX_ROWS][MATRIX_COLS];
+
+uint32_t tap_hold_entry(uint16_t keycode, keyrecord_t *record);
+
+static inline uint8_t tap_hold_flags(uint16_t keycode, keyrecord_t *record) {
+    return (uint8_t)(tap_hold_entry(keycode, record) >> 16);
+}
+
+// zero based home row mod slot, or HRM_SLOTS when the key is not a home row mod
+static inline uint8_t tap_hold_slot(uint16_t keycode, keyrecord_t *record) {
+    uint8_t slot = (uint8_t)(tap_hold_entry(keycode, record) >> 24);
+    return slot ? slot - 1 : HRM_SLOTS;
+}
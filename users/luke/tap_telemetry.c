@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "tap_telemetry.h"
+#include "print.h"
+#include "timer.h"
+
+#define NO_KEY 0xFF
+
+_Static_assert((TAP_TELEMETRY_RING_SIZE & (TAP_TELEMETRY_RING_SIZE - 1)) == 0, "TAP_TELEMETRY_RING_SIZE must be a power of two");
+_Static_assert(MATRIX_ROWS <= 16 && MATRIX_COLS <= 16, "decisions pack the position into one byte");
+
+typedef struct {
+    uint32_t seq;
+    uint16_t decide_ms; // press to the core settling the key
+    uint16_t held_ms;   // press to release
+    uint8_t  key;       // row << 4 | col
+    uint8_t  other;     // interrupting key, NO_KEY for none
+    uint8_t  outcome;
+    uint8_t  rule;
+} tap_decision_t;
+
+// a tap-hold key between its press and its release
+typedef struct {
+    uint16_t time;    // physical press time
+    uint16_t gap;     // time since the previous press
+    uint16_t presses; // press counter when it went down
+    uint16_t decide_ms;
+    uint8_t  key;
+    uint8_t  other;
+    uint8_t  note; // rule from the callbacks, TAP_RULE_COUNT for none
+    uint8_t  outcome;
+    bool     active;
+    bool     decided;
+} tap_open_t;
+
+static tap_decision_t ring[TAP_TELEMETRY_RING_SIZE];
+static uint32_t       decisions;
+static tap_open_t     open[TAP_TELEMETRY_OPEN];
+static uint16_t       presses;
+static uint16_t       last_press;
+
+static const char *const outcome_names[TAP_OUTCOME_COUNT] = {
+    [TAP_OUTCOME_TAP]  = "tap",
+    [TAP_OUTCOME_HOLD] = "hold",
+};
+
+static const char *const rule_names[TAP_RULE_COUNT] = {
+    [TAP_RULE_RELEASE]    = "release",
+    [TAP_RULE_TIMEOUT]    = "timeout",
+    [TAP_RULE_QUICK]      = "quick",
+    [TAP_RULE_FLOW]       = "flow",
+    [TAP_RULE_CHORDAL]    = "chordal",
+    [TAP_RULE_HOLD_OTHER] = "hold_other",
+    [TAP_RULE_PERMISSIVE] = "permissive",
+    [TAP_RULE_RETRO]      = "retro",
+};
+
+static uint8_t pack(keypos_t key) {
+    return key.row << 4 | key.col;
+}
+
+static tap_open_t *find(keypos_t key) {
+    uint8_t packed = pack(key);
+    for (uint8_t i = 0; i < TAP_TELEMETRY_OPEN; i++) {
+        if (open[i].active && open[i].key == packed) {
+            return &open[i];
+        }
+    }
+    return NULL;
+}
+
+// a free slot, or the oldest one when a release went missing
+static tap_open_t *claim(uint16_t now) {
+    tap_open_t *oldest = &open[0];
+    for (uint8_t i = 0; i < TAP_TELEMETRY_OPEN; i++) {
+        if (!open[i].active) {
+            return &open[i];
+        }
+        if (TIMER_DIFF_16(now, open[i].time) > TIMER_DIFF_16(now, oldest->time)) {
+            oldest = &open[i];
+        }
+    }
+    return oldest;
+}
+
+static bool is_tap_hold(uint16_t keycode) {
+    return IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode);
+}
+
+/**
+ * Raw events
+ * Called from pre_process_record, so presses are seen in physical order before the
+ * tapping code holds any of them back; the first press after a tap-hold key is its
+ * interrupting key
+ */
+void tap_telemetry_event(uint16_t keycode, keyrecord_t *record) {
+    if (!record->event.pressed || record->event.type != KEY_EVENT) {
+        return;
+    }
+
+    uint8_t packed = pack(record->event.key);
+    for (uint8_t i = 0; i < TAP_TELEMETRY_OPEN; i++) {
+        if (open[i].active && open[i].key != packed && !open[i].decided && open[i].other == NO_KEY) {
+            open[i].other = packed;
+        }
+    }
+
+    if (is_tap_hold(keycode)) {
+        tap_open_t *entry = find(record->event.key);
+        if (!entry) {
+            entry = claim(record->event.time);
+        }
+        *entry = (tap_open_t){
+            .time    = record->event.time,
+            .gap     = presses ? TIMER_DIFF_16(record->event.time, last_press) : UINT16_MAX,
+            .presses = presses + 1,
+            .key     = packed,
+            .other   = NO_KEY,
+            .note    = TAP_RULE_COUNT,
+            .active  = true,
+        };
+    }
+
+    presses++;
+    last_press = record->event.time;
+}
+
+void tap_telemetry_note(uint8_t rule, keyrecord_t *record, keyrecord_t *other) {
+    tap_open_t *entry = find(record->event.key);
+    if (!entry || entry->decided) {
+        return;
+    }
+    entry->note = rule;
+    if (other) {
+        entry->other = pack(other->event.key);
+    }
+}
+
+// the core applies the flow tap term against the previous press, mirror that check
+void tap_telemetry_flow(uint16_t term, keyrecord_t *record) {
+    tap_open_t *entry = find(record->event.key);
+    if (entry && term && entry->gap < term) {
+        tap_telemetry_note(TAP_RULE_FLOW, record, NULL);
+    }
+}
+
+static void push(tap_open_t *entry, uint16_t held_ms) {
+    ring[decisions & (TAP_TELEMETRY_RING_SIZE - 1)] = (tap_decision_t){
+        .seq       = decisions,
+        .decide_ms = entry->decide_ms,
+        .held_ms   = held_ms,
+        .key       = entry->key,
+        .other     = entry->other,
+        .outcome   = entry->outcome,
+        .rule      = entry->note,
+    };
+    decisions++;
+    entry->active = false;
+}
+
+/**
+ * Decisions
+ * post_process_record sees a tap-hold press once the core has settled it, tap.count tells
+ * which way; a note from the callbacks only names the rule when it agrees with the outcome,
+ * otherwise the release or the timeout did. The entry is finished on release, when the
+ * hold time is known and retro tapping has had its say.
+ */
+void tap_telemetry_record(uint16_t keycode, keyrecord_t *record) {
+    if (record->event.type != KEY_EVENT || !is_tap_hold(keycode)) {
+        return;
+    }
+
+    tap_open_t *entry = find(record->event.key);
+    if (!entry) {
+        return;
+    }
+
+    if (record->event.pressed) {
+        bool tap = record->tap.count > 0;
+        bool noted;
+        switch (entry->note) {
+            case TAP_RULE_FLOW:
+            case TAP_RULE_CHORDAL:
+                noted = tap;
+                break;
+            case TAP_RULE_HOLD_OTHER:
+            case TAP_RULE_PERMISSIVE:
+                noted = !tap;
+                break;
+            default:
+                noted = false;
+        }
+        if (!noted) {
+            entry->note = !tap ? TAP_RULE_TIMEOUT : record->tap.count > 1 ? TAP_RULE_QUICK : TAP_RULE_RELEASE;
+        }
+        entry->outcome   = tap ? TAP_OUTCOME_TAP : TAP_OUTCOME_HOLD;
+        entry->decide_ms = timer_elapsed(entry->time);
+        entry->decided   = true;
+        return;
+    }
+
+    if (!entry->decided) {
+        return;
+    }
+    // nothing else went down while it was held, so the release sends the tap instead
+    if (entry->note == TAP_RULE_TIMEOUT && entry->presses == presses && get_retro_tapping(keycode, record)) {
+        entry->outcome = TAP_OUTCOME_TAP;
+        entry->note    = TAP_RULE_RETRO;
+    }
+    push(entry, TIMER_DIFF_16(record->event.time, entry->time));
+}
+
+/**
+ * Console dump
+ * One line per decision still in the ring, oldest first; the sequence number lets
+ * tools/tap_decisions.py merge overlapping dumps without counting anything twice
+ */
+void tap_telemetry_report(void) {
+    uint32_t count = decisions < TAP_TELEMETRY_RING_SIZE ? decisions : TAP_TELEMETRY_RING_SIZE;
+    for (uint32_t n = decisions - count; n != decisions; n++) {
+        tap_decision_t *d = &ring[n & (TAP_TELEMETRY_RING_SIZE - 1)];
+        uprintf("thd %lu %u %u %s %s %u %u", d->seq, d->key >> 4, d->key & 0xF, outcome_names[d->outcome], rule_names[d->rule], d->decide_ms, d->held_ms);
+        if (d->other == NO_KEY) {
+            uprintf(" - -\n");
+        } else {
+            uprintf(" %u %u\n", d->other >> 4, d->other & 0xF);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "luke.h"
+
+// finished decisions kept for the console dump, a power of two
+#ifndef TAP_TELEMETRY_RING_SIZE
+#    define TAP_TELEMETRY_RING_SIZE 32
+#endif
+
+// tap-hold keys tracked from press to release at the same time
+#define TAP_TELEMETRY_OPEN 4
+
+enum tap_outcome {
+    TAP_OUTCOME_TAP,
+    TAP_OUTCOME_HOLD,
+    TAP_OUTCOME_COUNT
+};
+
+enum tap_rule {
+    TAP_RULE_RELEASE,     // released inside the tapping term
+    TAP_RULE_TIMEOUT,     // still down when the tapping term ran out
+    TAP_RULE_QUICK,       // repeat of a tap inside the quick tap term
+    TAP_RULE_FLOW,        // pressed inside the flow tap term of the previous key
+    TAP_RULE_CHORDAL,     // same hand chord settled as a tap
+    TAP_RULE_HOLD_OTHER,  // hold on other key press
+    TAP_RULE_PERMISSIVE,  // another key tapped inside the tapping term
+    TAP_RULE_RETRO,       // held alone past the term, tapped on release
+    TAP_RULE_COUNT
+};
+
+/**
+ * Instrumentation
+ * The tap-hold callbacks note every answer that settles a key; the rule is only kept if
+ * the outcome the core reports later agrees with it. Without TAP_TELEMETRY_ENABLE the
+ * notes expand to nothing.
+ */
+#ifdef TAP_TELEMETRY_ENABLE
+#    define TAP_NOTE(rule, record, other) tap_telemetry_note(rule, record, other)
+#    define TAP_NOTE_FLOW(term, record)   tap_telemetry_flow(term, record)
+
+void tap_telemetry_event(uint16_t keycode, keyrecord_t *record);
+void tap_telemetry_note(uint8_t rule, keyrecord_t *record, keyrecord_t *other);
+void tap_telemetry_flow(uint16_t term, keyrecord_t *record);
+void tap_telemetry_record(uint16_t keycode, keyrecord_t *record);
+void tap_telemetry_report(void);
+#else
+#    define TAP_NOTE(rule, record, other)
+#    define TAP_NOTE_FLOW(term, record)
+#endif
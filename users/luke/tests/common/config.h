@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "test_common.h"
+
+// matrix size, QMK_KEYBOARD_H and the LUKE_* paths of the board under test, generated
+// by tools/qmk_tests.py from `qmk info`
+#include "board_config.h"
+
+// the board's keymap config and ours, exactly as the firmware builds them
+#include LUKE_KEYMAP_CONFIG
+#include LUKE_USER_CONFIG
@@ -0,0 +1,6 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// the board's keymap.c as it is, with keymaps[] renamed so the fixture keeps serving the
+// core; replay.hpp loads luke_keymaps into the fixture instead
+#define keymaps luke_keymaps
+#include LUKE_KEYMAP_C
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <dirent.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "keyboard_report_util.hpp"
+#include "keycode.h"
+#include "test_common.hpp"
+#include "test_fixture.hpp"
+#include "test_keymap_key.hpp"
+
+extern "C" {
+#include "luke.h"
+
+extern const uint16_t luke_keymaps[][MATRIX_ROWS][MATRIX_COLS];
+extern const uint8_t  key_index[MATRIX_ROWS][MATRIX_COLS];
+}
+
+using testing::_;
+using testing::Invoke;
+
+/**
+ * Traces
+ * One event per line, `<ms> <key> <d|u>`: the time from the start of the trace, the key
+ * number from LAYER_KEYS in layout.h and whether it went down or up. `# text: ...` holds
+ * what the trace types, when known; any other # line is a comment. See tests/README.md
+ */
+struct TraceEvent {
+    uint32_t time;
+    uint8_t  key;
+    bool     pressed;
+};
+
+struct Trace {
+    std::string             name;
+    std::string             text;
+    std::vector<TraceEvent> events;
+
+    size_t presses() const {
+        return std::count_if(events.begin(), events.end(), [](const TraceEvent &event) { return event.pressed; });
+    }
+};
+
+inline Trace load_trace(const std::string &dir, const std::string &name) {
+    Trace         trace{name, "", {}};
+    std::ifstream file(dir + "/" + name);
+    std::string   line;
+    const std::string text = "# text: ";
+
+    while (std::getline(file, line)) {
+        if (line.compare(0, text.size(), text) == 0) {
+            trace.text = line.substr(text.size());
+            continue;
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        uint32_t           time, key;
+        char               state;
+        if (!(fields >> time >> key >> state) || (state != 'd' && state != 'u')) {
+            ADD_FAILURE() << name << ": bad line '" << line << "'";
+            continue;
+        }
+        trace.events.push_back({time, (uint8_t)key, state == 'd'});
+    }
+    return trace;
+}
+
+// every *.trace under LUKE_TRACES, by name
+inline std::vector<Trace> load_traces() {
+    std::vector<std::string> names;
+    if (DIR *dir = opendir(LUKE_TRACES)) {
+        while (struct dirent *entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 6 && name.compare(name.size() - 6, 6, ".trace") == 0) {
+                names.push_back(name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+
+    std::vector<Trace> traces;
+    for (auto &name : names) {
+        traces.push_back(load_trace(LUKE_TRACES, name));
+    }
+    return traces;
+}
+
+/**
+ * Replay fixture
+ * Serves the board's own keymap.c through the fixture and plays traces into the test
+ * matrix at their recorded times, one scan per millisecond, so every tap-hold decision is
+ * made by the core's action_tapping.c with our callbacks. The host side is decoded back
+ * into the text it would show.
+ */
+class ReplayFixture : public TestFixture {
+   protected:
+    std::map<uint8_t, KeymapKey> positions; // by key number
+    std::string                  typed;
+    report_keyboard_t            last{};
+
+    void load_board_keymap() {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+                    add_key(KeymapKey(layer, col, row, luke_keymaps[layer][row][col]));
+                }
+                if (key_index[row][col]) {
+                    positions.emplace(key_index[row][col], KeymapKey(DFLT, col, row, luke_keymaps[DFLT][row][col]));
+                }
+            }
+        }
+    }
+
+    // false when the trace uses keys this board does not have, the Iris number row on the Chiri
+    bool fits(const Trace &trace) const {
+        return std::all_of(trace.events.begin(), trace.events.end(), [this](const TraceEvent &event) { return positions.count(event.key); });
+    }
+
+    void replay(TestDriver &driver, const Trace &trace, uint32_t settle_ms = 1000) {
+        typed.clear();
+        last = {};
+        EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(Invoke([this](const report_keyboard_t &report) { host_report(report); }));
+
+        uint32_t start = timer_read32();
+        size_t   i     = 0;
+        while (i < trace.events.size()) {
+            uint32_t time = trace.events[i].time;
+            uint32_t now  = timer_read32() - start;
+            if (time > now) {
+                idle_for(time - now);
+            }
+            // everything recorded in the same millisecond lands in the same scan
+            for (; i < trace.events.size() && trace.events[i].time == time; i++) {
+                KeymapKey &key = positions.at(trace.events[i].key);
+                if (trace.events[i].pressed) {
+                    key.press();
+                } else {
+                    key.release();
+                }
+            }
+            run_one_scan_loop();
+        }
+        idle_for(settle_ms);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+    }
+
+   private:
+    void host_report(const report_keyboard_t &report) {
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+            uint8_t code = report.keys[i];
+            if (code && std::find(std::begin(last.keys), std::end(last.keys), code) == std::end(last.keys)) {
+                type(code, report.mods);
+            }
+        }
+        last = report;
+    }
+
+    // what the host shows for a newly pressed key; chords and unnamed keys as {mods:code}
+    void type(uint8_t code, uint8_t mods) {
+        static const char *const punctuation[][2] = {
+            {" ", " "}, {"-", "_"}, {"=", "+"}, {"[", "{"}, {"]", "}"}, {"\\", "|"}, {"#", "~"}, {";", ":"}, {"'", "\""}, {"`", "~"}, {",", "<"}, {".", ">"}, {"/", "?"},
+        };
+        static const char *const digits[][2] = {
+            {"1", "!"}, {"2", "@"}, {"3", "#"}, {"4", "$"}, {"5", "%"}, {"6", "^"}, {"7", "&"}, {"8", "*"}, {"9", "("}, {"0", ")"},
+        };
+        const uint8_t shift = MOD_BIT(KC_LEFT_SHIFT) | MOD_BIT(KC_RIGHT_SHIFT);
+
+        if (code == KC_BACKSPACE && !(mods & ~shift)) {
+            if (!typed.empty()) {
+                typed.pop_back();
+            }
+            return;
+        }
+        if (!(mods & ~shift)) {
+            bool shifted = mods & shift;
+            if (code >= KC_A && code <= KC_Z) {
+                typed += (char)((shifted ? 'A' : 'a') + code - KC_A);
+                return;
+            }
+            if (code >= KC_1 && code <= KC_0) {
+                typed += digits[code - KC_1][shifted];
+                return;
+            }
+            if (code >= KC_SPACE && code <= KC_SLASH) {
+                typed += punctuation[code - KC_SPACE][shifted];
+                return;
+            }
+            if (code == KC_ENTER) {
+                typed += "\n";
+                return;
+            }
+        }
+        char chord[16];
+        snprintf(chord, sizeof(chord), "{%02X:%02X}", mods, code);
+        typed += chord;
+    }
+};
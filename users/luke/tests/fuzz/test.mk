@@ -0,0 +1,7 @@
+# the userspace the streams run through on top of the core: the board's keymap.c and our
+# tap-hold callbacks, with fuzz.h's invariants checked in the suite's own hooks; LUKE_USER
+# and LUKE_TEST are set by tools/qmk_tests.py, which stages this suite once per qmk.json
+# target
+SRC += $(LUKE_TEST)/luke_keymap.c $(LUKE_USER)/tap_hold.c $(LUKE_USER)/game_mode.c
+# quoted includes only, our sched.h would shadow the system one gtest pulls in
+OPT_DEFS += -iquote $(LUKE_USER)
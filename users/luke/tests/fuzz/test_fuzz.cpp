@@ -0,0 +1,456 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <set>
+#include "replay.hpp"
+
+extern "C" {
+#include "fuzz.h"
+#include "game_mode.h"
+#include "tap_hold.h"
+
+/**
+ * Invariants
+ * fuzz.c's, kept by the same hooks luke.c calls it from: every press is counted into
+ * pre_process, a tap-hold press again when the core hands it on as a tap or a hold under
+ * whatever keycode the layers give it by then, and the layer the last TO() asked for is
+ * remembered for the check once the stream has settled
+ */
+static struct {
+    bool     on;
+    uint8_t  failures;
+    uint16_t presses; // put in the matrix
+    uint16_t seen;    // reached pre_process
+    uint8_t  pending[MATRIX_ROWS][MATRIX_COLS];
+    bool     tracked[MATRIX_ROWS][MATRIX_COLS];
+    uint8_t  expected_layer;
+} checks;
+
+layer_state_t layer_state_set_user(layer_state_t state) {
+    return game_mode_layer_state(state);
+}
+
+bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    keypos_t key = record->event.key;
+    if (!checks.on || !record->event.pressed || record->event.type != KEY_EVENT || key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return true;
+    }
+    checks.seen++;
+    if (fuzz_tap_hold(keycode)) {
+        checks.pending[key.row][key.col]++;
+        checks.tracked[key.row][key.col] = true;
+    }
+    return true;
+}
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    keypos_t key = record->event.key;
+    if (record->event.pressed && key.row < MATRIX_ROWS && key.col < MATRIX_COLS && checks.tracked[key.row][key.col]) {
+        if (checks.pending[key.row][key.col]) {
+            checks.pending[key.row][key.col]--;
+        } else if (fuzz_tap_hold(keycode)) {
+            checks.failures |= FUZZ_EXTRA_OUTCOME;
+        }
+    }
+    if (record->event.pressed && IS_QK_TO(keycode)) {
+        checks.expected_layer = QK_TO_GET_LAYER(keycode);
+    }
+    return fuzz_allowed(keycode);
+}
+}
+
+namespace {
+
+// stream shape, as tools/fuzz.py writes them for the boards
+constexpr size_t   MAX_ROLLOVER  = 6; // keys down at once
+constexpr double   BURST_CHANCE  = 0.15;
+constexpr int      BURST_LENGTH  = 3, BURST_LENGTH_MAX = 8;
+constexpr int      BURST_GAP_MS  = 0, BURST_GAP_MS_MAX = 15;
+constexpr double   HOLD_CHANCE   = 0.1; // a gap long enough to settle the keys down as holds
+constexpr int      HOLD_GAP_MS   = 150, HOLD_GAP_MS_MAX = 450;
+constexpr double   SPECIAL_SHARE = 0.5; // presses taken from the tap-hold, mod and layer keys
+constexpr uint32_t PEAK_WINDOW   = 250;
+
+// keep in step with enum fuzz_failure in fuzz.h
+const char *const failure_names[] = {"stuck mods", "stuck keys", "stuck layer", "lost tap-hold outcome", "extra tap-hold outcome", "bad stream", "unseen press"};
+
+std::string describe(uint8_t failures) {
+    std::string text;
+    for (size_t bit = 0; bit < sizeof(failure_names) / sizeof(*failure_names); bit++) {
+        if (failures >> bit & 1) {
+            text += (text.empty() ? "" : ", ") + std::string(failure_names[bit]);
+        }
+    }
+    return text.empty() ? "ok" : text;
+}
+
+// LUKE_FUZZ_* from the environment, see `make fuzz`
+uint32_t setting(const char *name, uint32_t fallback) {
+    const char *value = getenv(name);
+    return value && *value ? strtoul(value, nullptr, 0) : fallback;
+}
+
+// a press and its release, by their places in the stream they came from
+struct Stroke {
+    size_t   down, up;
+    uint32_t down_ms, up_ms;
+    uint8_t  key;
+};
+
+std::vector<Stroke> strokes_of(const Trace &trace) {
+    std::map<uint8_t, size_t> down;
+    std::vector<Stroke>       strokes;
+    for (size_t i = 0; i < trace.events.size(); i++) {
+        const TraceEvent &event = trace.events[i];
+        if (event.pressed) {
+            down[event.key] = i;
+        } else if (down.count(event.key)) {
+            size_t press = down[event.key];
+            strokes.push_back({press, i, trace.events[press].time, event.time, event.key});
+            down.erase(event.key);
+        }
+    }
+    std::sort(strokes.begin(), strokes.end(), [](const Stroke &a, const Stroke &b) { return a.down < b.down; });
+    return strokes;
+}
+
+// back to a stream, the surviving keystrokes in their original order and at their original
+// times, less the quiet stretch before the first of them
+Trace trace_of(const std::string &name, const std::vector<Stroke> &strokes) {
+    std::vector<std::pair<size_t, TraceEvent>> timeline;
+    for (const Stroke &stroke : strokes) {
+        timeline.push_back({stroke.down, {stroke.down_ms, stroke.key, true}});
+        timeline.push_back({stroke.up, {stroke.up_ms, stroke.key, false}});
+    }
+    std::sort(timeline.begin(), timeline.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    Trace    trace{name, "", {}};
+    uint32_t start = timeline.empty() ? 0 : timeline.front().second.time;
+    for (auto &[order, event] : timeline) {
+        trace.events.push_back({event.time - start, event.key, event.pressed});
+    }
+    return trace;
+}
+
+/**
+ * Shrinking
+ * Delta debugging over keystrokes, the way tools/fuzz.py shrinks on the boards: chunks of
+ * them are dropped while the same invariant still breaks, down to single keystrokes
+ */
+Trace minimize(const std::function<uint8_t(const Trace &)> &check, const Trace &trace, uint8_t failures) {
+    std::vector<Stroke> strokes = strokes_of(trace);
+    size_t              chunks  = 2;
+    while (strokes.size() >= 2) {
+        size_t size    = std::max<size_t>(strokes.size() / chunks, 1);
+        bool   dropped = false;
+        for (size_t start = 0; start < strokes.size(); start += size) {
+            std::vector<Stroke> rest(strokes.begin(), strokes.begin() + start);
+            rest.insert(rest.end(), strokes.begin() + std::min(start + size, strokes.size()), strokes.end());
+            if (!rest.empty() && (check(trace_of(trace.name, rest)) & failures)) {
+                strokes = rest;
+                chunks  = std::max<size_t>(chunks - 1, 2);
+                dropped = true;
+                break;
+            }
+        }
+        if (!dropped) {
+            if (size == 1) {
+                break;
+            }
+            chunks = std::min(chunks * 2, strokes.size());
+        }
+    }
+    return trace_of(trace.name, strokes);
+}
+
+// most presses in any PEAK_WINDOW, per second
+double peak_rate(const Trace &trace) {
+    std::vector<uint32_t> times;
+    for (const TraceEvent &event : trace.events) {
+        if (event.pressed) {
+            times.push_back(event.time);
+        }
+    }
+    size_t peak = 0, first = 0;
+    for (size_t last = 0; last < times.size(); last++) {
+        while (times[last] - times[first] >= PEAK_WINDOW) {
+            first++;
+        }
+        peak = std::max(peak, last - first + 1);
+    }
+    return peak * 1000.0 / PEAK_WINDOW;
+}
+
+// in the trace format, so a failure can be saved and rerun with LUKE_FUZZ_REPLAY
+void print_trace(const Trace &trace, uint8_t failures) {
+    printf("# %s on %s: %s\n", trace.name.c_str(), LUKE_BOARD, describe(failures).c_str());
+    for (const TraceEvent &event : trace.events) {
+        printf("%u %u %c\n", event.time, event.key, event.pressed ? 'd' : 'u');
+    }
+}
+
+} // namespace
+
+/**
+ * Rollover fuzzing
+ * Seeded press/release streams, rolls at typing speed, bursts well past 20 keys/s and
+ * holds across the tapping terms, played into this board's keymap through the core's
+ * matrix scan and tap-hold machinery, one scan per millisecond. Once a stream has
+ * settled no mods, keys or layers may be left behind and every tap-hold press has to
+ * have settled exactly once; a stream that breaks one is shrunk and printed.
+ */
+class Fuzz : public ReplayFixture {
+   protected:
+    std::vector<uint8_t> keys;    // key numbers this board has
+    std::vector<uint8_t> special; // those that are tap-hold, mod or layer keys on some layer
+    double               busy_s = 0; // host time in the scans that carried the last stream's events
+
+    void load() {
+        load_board_keymap();
+        for (auto &[number, key] : positions) {
+            keys.push_back(number);
+            for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+                if (fuzz_special(luke_keymaps[layer][key.position.row][key.position.col])) {
+                    special.push_back(number);
+                    break;
+                }
+            }
+        }
+    }
+
+    Trace generate(uint32_t seed, double rate, size_t length) {
+        std::mt19937 rng(seed);
+        auto         uniform = [&](int low, int high) { return std::uniform_int_distribution<int>(low, high)(rng); };
+        auto         chance  = [&](double p) { return std::uniform_real_distribution<>(0, 1)(rng) < p; };
+
+        Trace                       trace{"seed " + std::to_string(seed), "", {}};
+        std::vector<uint8_t>        held;
+        std::map<uint8_t, uint32_t> changed;
+        uint32_t                    now   = 0;
+        int                         burst = 0;
+
+        auto gap = [&]() -> uint32_t {
+            if (burst) {
+                burst--;
+                return uniform(BURST_GAP_MS, BURST_GAP_MS_MAX);
+            }
+            double roll = std::uniform_real_distribution<>(0, 1)(rng);
+            if (roll < BURST_CHANCE) {
+                burst = uniform(BURST_LENGTH, BURST_LENGTH_MAX);
+                return uniform(BURST_GAP_MS, BURST_GAP_MS_MAX);
+            }
+            if (roll < BURST_CHANCE + HOLD_CHANCE) {
+                return uniform(HOLD_GAP_MS, HOLD_GAP_MS_MAX);
+            }
+            return std::min<uint32_t>(std::exponential_distribution<>(rate / 1000)(rng), 1000);
+        };
+        // a key changes at most once a scan, as in a real matrix
+        auto add = [&](uint8_t key, bool pressed) {
+            now += gap();
+            if (changed.count(key) && changed[key] >= now) {
+                now = changed[key] + 1;
+            }
+            changed[key] = now;
+            trace.events.push_back({now, key, pressed});
+        };
+
+        // presses stop once only the releases of what is down still fit
+        while (trace.events.size() + held.size() + 1 < length) {
+            if (!held.empty() && (held.size() >= MAX_ROLLOVER || chance(0.45))) {
+                size_t  i   = uniform(0, held.size() - 1);
+                uint8_t key = held[i];
+                held.erase(held.begin() + i);
+                add(key, false);
+                continue;
+            }
+            const std::vector<uint8_t> &pool = chance(SPECIAL_SHARE) && !special.empty() ? special : keys;
+            uint8_t                     key  = pool[uniform(0, pool.size() - 1)];
+            if (std::find(held.begin(), held.end(), key) == held.end()) {
+                held.push_back(key);
+                add(key, true);
+            }
+        }
+        std::shuffle(held.begin(), held.end(), rng);
+        for (uint8_t key : held) {
+            add(key, false);
+        }
+        return trace;
+    }
+
+    // the stream from a clean keyboard, then the settle time; the invariants it broke
+    uint8_t play(TestDriver &driver, const Trace &trace) {
+        last = {};
+        EXPECT_CALL(driver, send_keyboard_mock(_)).WillRepeatedly(Invoke([this](const report_keyboard_t &report) { last = report; }));
+        layer_clear();
+        clear_oneshot_mods();
+        clear_keyboard();
+        memset(&checks, 0, sizeof(checks));
+        checks.expected_layer = DFLT;
+        checks.on             = true;
+        busy_s                = 0;
+
+        std::set<uint8_t> down;
+        uint32_t          start = timer_read32();
+        size_t            i     = 0;
+        while (i < trace.events.size()) {
+            uint32_t time = trace.events[i].time;
+            uint32_t now  = timer_read32() - start;
+            if (time > now) {
+                idle_for(time - now);
+            }
+            for (; i < trace.events.size() && trace.events[i].time == time; i++) {
+                const TraceEvent &event = trace.events[i];
+                if (!positions.count(event.key) || down.count(event.key) == event.pressed) {
+                    checks.failures |= FUZZ_BAD_STREAM;
+                    continue;
+                }
+                if (event.pressed) {
+                    down.insert(event.key);
+                    positions.at(event.key).press();
+                    checks.presses++;
+                } else {
+                    down.erase(event.key);
+                    positions.at(event.key).release();
+                }
+            }
+            auto begin = std::chrono::steady_clock::now();
+            run_one_scan_loop();
+            busy_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+        // a stream that ends with keys down is malformed, let go of them before settling
+        for (uint8_t key : down) {
+            positions.at(key).release();
+            checks.failures |= FUZZ_BAD_STREAM;
+        }
+        idle_for(FUZZ_SETTLE_MS);
+        testing::Mock::VerifyAndClearExpectations(&driver);
+        checks.on = false;
+        return check();
+    }
+
+   private:
+    uint8_t check() {
+        uint8_t failures = checks.failures;
+        if (get_mods() | get_weak_mods() | get_oneshot_mods()) {
+            failures |= FUZZ_STUCK_MODS;
+        }
+        if (last.mods || std::any_of(std::begin(last.keys), std::end(last.keys), [](uint8_t code) { return code != 0; })) {
+            failures |= FUZZ_STUCK_KEYS;
+        }
+        // TO(DFLT) leaves DFLT's own bit on, nothing else may be
+        layer_state_t want = (layer_state_t)1 << checks.expected_layer;
+        if (layer_state != want && !(checks.expected_layer == DFLT && layer_state == 0)) {
+            failures |= FUZZ_STUCK_LAYER;
+        }
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                if (checks.pending[row][col]) {
+                    failures |= FUZZ_LOST_OUTCOME;
+                }
+            }
+        }
+        if (checks.seen < checks.presses) {
+            failures |= FUZZ_UNSEEN_PRESS;
+        }
+        return failures;
+    }
+};
+
+/**
+ * Streams
+ * LUKE_FUZZ_SEEDS streams from LUKE_FUZZ_START at LUKE_FUZZ_RATE keys/s between bursts.
+ * Prints the stream rate the core was fed, the peak over 250 ms and how many events a
+ * second the host got through in the scans that carried them, and each failure shrunk
+ * in the trace format.
+ */
+TEST_F(Fuzz, StreamsKeepTheInvariants) {
+    TestDriver driver;
+    load();
+    ASSERT_FALSE(keys.empty());
+
+    uint32_t seeds = setting("LUKE_FUZZ_SEEDS", 100);
+    uint32_t first = setting("LUKE_FUZZ_START", 0);
+    uint32_t rate  = setting("LUKE_FUZZ_RATE", 25);
+
+    uint32_t failed = 0, events = 0, stream_ms = 0;
+    double   busy = 0, peak = 0;
+    for (uint32_t seed = first; seed < first + seeds; seed++) {
+        Trace   trace    = generate(seed, rate, FUZZ_MAX_EVENTS);
+        uint8_t failures = play(driver, trace);
+        events += trace.events.size();
+        stream_ms += trace.events.back().time;
+        busy += busy_s;
+        peak = std::max(peak, peak_rate(trace));
+        if (!failures) {
+            continue;
+        }
+
+        failed++;
+        ADD_FAILURE() << trace.name << ": " << describe(failures) << ", mods 0x" << std::hex << +(get_mods() | get_weak_mods() | get_oneshot_mods()) << ", layers 0x" << layer_state;
+        Trace shrunk = minimize([&](const Trace &candidate) { return play(driver, candidate); }, trace, failures);
+        print_trace(shrunk, failures);
+    }
+
+    printf("%s: %u streams, %u failed, %u events\n", LUKE_BOARD, seeds, failed, events);
+    printf("stream rate %.1f events/s, peak %.0f presses/s over %u ms\n", events * 1000.0 / std::max<uint32_t>(stream_ms, 1), peak, PEAK_WINDOW);
+    printf("processing %.0f events/s on this host, in the scans that carried them\n", events / std::max(busy, 1e-9));
+    EXPECT_GT(peak, 20) << "no stream burst past 20 keys/s";
+}
+
+// a stream saved from a failure above, LUKE_FUZZ_REPLAY=<path of the .trace>
+TEST_F(Fuzz, ReplaysASavedStream) {
+    const char *path = getenv("LUKE_FUZZ_REPLAY");
+    if (!path || !*path) {
+        GTEST_SKIP() << "no LUKE_FUZZ_REPLAY";
+    }
+    TestDriver driver;
+    load();
+
+    std::string file  = path;
+    size_t      slash = file.rfind('/');
+    Trace       trace = slash == std::string::npos ? load_trace(".", file) : load_trace(file.substr(0, slash), file.substr(slash + 1));
+    ASSERT_FALSE(trace.events.empty()) << "nothing to replay in " << path;
+    uint8_t failures = play(driver, trace);
+    EXPECT_EQ(failures, 0) << describe(failures);
+    print_trace(trace, failures);
+}
+
+/**
+ * Shrinking
+ * Against a made-up invariant, broken only while two given keys are down together: the
+ * stream shrinks to those two keystrokes and still breaks it
+ */
+TEST_F(Fuzz, ShrinksToTheKeystrokesThatFail) {
+    load();
+    ASSERT_GE(keys.size(), 2u);
+    uint8_t a = keys.front(), b = keys.back();
+
+    auto check = [&](const Trace &trace) -> uint8_t {
+        std::set<uint8_t> down;
+        for (const TraceEvent &event : trace.events) {
+            if (event.pressed) {
+                down.insert(event.key);
+            } else {
+                down.erase(event.key);
+            }
+            if (down.count(a) && down.count(b)) {
+                return FUZZ_STUCK_MODS;
+            }
+        }
+        return 0;
+    };
+
+    uint32_t seed = 0;
+    Trace    trace;
+    do {
+        trace = generate(seed++, 25, FUZZ_MAX_EVENTS);
+    } while (!check(trace) && seed < 10000);
+    ASSERT_TRUE(check(trace)) << "no stream held the two keys together";
+
+    Trace shrunk = minimize(check, trace, FUZZ_STUCK_MODS);
+    EXPECT_EQ(shrunk.events.size(), 4u);
+    EXPECT_TRUE(check(shrunk));
+    EXPECT_EQ(shrunk.events.front().time, 0u);
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+#include "harness.h"
+#include "luke.h"
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+}
+
+/**
+ * Hot callback micro-benchmark
+ * Times the callbacks the core calls on every key event, natively, against the Chiri
+ * keymap: each one runs over a fixed set of inputs a number of times and the fastest
+ * round counts, so scheduler noise only ever makes a round slower. Prints one
+ * `bench <callback> <ns per call>` line each, read by tools/bench.py.
+ * Host nanoseconds, not target cycles: good for catching a callback that got slower,
+ * not for a cycle budget on the RP2040
+ */
+namespace {
+
+constexpr int ROUNDS = 200;
+constexpr int PASSES = 200; // over the inputs per round
+
+volatile uint32_t sink;
+
+template <typename F>
+double fastest_ns(size_t inputs, F &&run) {
+    double best = 1e30;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < PASSES; pass++) {
+            run();
+        }
+        std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - start;
+        best = std::min(best, took.count() / (PASSES * inputs));
+    }
+    return best;
+}
+
+keyrecord_t record_at(uint8_t row, uint8_t col, bool pressed, uint16_t time) {
+    keyrecord_t record = {};
+    record.event       = (keyevent_t){.key = (keypos_t){.col = col, .row = row}, .time = time, .type = KEY_EVENT, .pressed = pressed};
+    record.keycode     = keymaps[DFLT][row][col];
+    return record;
+}
+
+} // namespace
+
+int main() {
+    host_reset();
+    host_quiet = true;
+    keyboard_post_init_user();
+
+    // every key of the DFLT layer, pressed; the term callbacks only see tap-hold keys on
+    // the board, but a table miss has to stay cheap too
+    std::vector<keyrecord_t> presses;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (keymaps[DFLT][row][col] != KC_NO) {
+                presses.push_back(record_at(row, col, true, 0));
+            }
+        }
+    }
+
+    // typing: every key down then up 80 ms later, 40 ms between presses
+    std::vector<keyrecord_t> events;
+    uint16_t                 time = 0;
+    for (auto &press : presses) {
+        keyrecord_t down = press, up = press;
+        down.event.time  = time;
+        up.event.pressed = false;
+        up.event.time    = time + 80;
+        up.tap.count     = 1;
+        events.push_back(down);
+        events.push_back(up);
+        time += 40;
+    }
+
+    const layer_state_t states[] = {0, 1 << NAV, 0, 1 << NUM, 1 << SYS, 1 << NAV | 1 << SYS, 0};
+
+    printf("bench get_tapping_term %.2f\n", fastest_ns(presses.size(), [&] {
+               for (auto &record : presses) {
+                   sink = get_tapping_term(record.keycode, &record);
+               }
+           }));
+    printf("bench get_quick_tap_term %.2f\n", fastest_ns(presses.size(), [&] {
+               for (auto &record : presses) {
+                   sink = get_quick_tap_term(record.keycode, &record);
+               }
+           }));
+    printf("bench get_flow_tap_term %.2f\n", fastest_ns(presses.size(), [&] {
+               for (auto &record : presses) {
+                   sink = get_flow_tap_term(record.keycode, &record, KC_A);
+               }
+           }));
+    printf("bench layer_state_set_user %.2f\n", fastest_ns(ARRAY_SIZE(states), [&] {
+               for (auto state : states) {
+                   sink = layer_state_set_user(state);
+               }
+           }));
+    printf("bench post_process_record_user %.2f\n", fastest_ns(events.size(), [&] {
+               for (auto &record : events) {
+                   keyrecord_t copy = record;
+                   post_process_record_user(copy.keycode, &copy);
+               }
+           }));
+    return 0;
+}
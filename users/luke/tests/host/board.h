@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "quantum.h"
+
+// an 8x6 split matrix, four rows a half, for the Chiri CE keymap.c the harness builds as
+// it is; the key order is the one keymap.c lists, which is all the userspace relies on
+#define LAYOUT( \
+    k0, k1, k2, k3, k4, k5, k6, k7, k8, k9, k10, k11, k12, k13, k14, k15, k16, k17, k18, k19, k20, k21, \
+    k22, k23, k24, k25, k26, k27, k28, k29, k30, k31, k32, k33, k34, k35, k36, k37, k38, k39, k40, k41, k42, k43) { \
+    {k0, k1, k2, k3, k4, k5}, \
+    {k6, k7, k8, k9, k10, k11}, \
+    {k12, k13, k14, k15, k16, k17}, \
+    {k18, k19, k20, k21, k22, k23}, \
+    {k24, k25, k26, k27, k28, k29}, \
+    {k30, k31, k32, k33, k34, k35}, \
+    {k36, k37, k38, k39, k40, k41}, \
+    {k42, k43, KC_NO, KC_NO, KC_NO, KC_NO} \
+}
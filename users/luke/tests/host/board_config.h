@@ -0,0 +1,8 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#define MATRIX_ROWS          8
+#define MATRIX_COLS          6
+#define RGB_MATRIX_LED_COUNT 44
+
+#define QMK_KEYBOARD_H "board.h"
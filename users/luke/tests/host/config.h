@@ -0,0 +1,7 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// the board under test, then its keymap config and ours, exactly as the firmware builds them
+#include "board_config.h"
+#include LUKE_KEYMAP_CONFIG
+#include LUKE_USER_CONFIG
@@ -0,0 +1,324 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "harness.h"
+#include "debounce.h"
+}
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+/**
+ * Debounce comparison
+ * Replays one chattering typing trace through debounce_swar.c and through models of the
+ * stock sym_defer_g and asym_eager_defer_pk, and prints the host cost per scan and the
+ * press and release latency of each. The models follow the algorithms as QMK documents
+ * them, written here from that description, not QMK's sources: good for the latency,
+ * which only depends on the algorithm, and a rough guide to the cost. Cycles on the
+ * RP2040 come from the PROF_DEBOUNCE hook in a PROFILE_ENABLE build, see tests/README.md
+ */
+namespace {
+
+constexpr int SCANS_PER_MS = 4; // the RP2040 scans several times a millisecond
+constexpr int ROUNDS       = 50;
+
+volatile matrix_row_t sink;
+
+struct edge {
+    uint32_t ms;
+    uint8_t  row, col;
+    bool     closed;
+};
+
+struct keystroke {
+    uint8_t  row, col;
+    uint32_t down, up; // first contact, first break of the release
+};
+
+/**
+ * Trace
+ * Typing at about 8 keys a second with rolls, every contact bouncing for up to 3 ms on
+ * press and on release, and the odd bounce mid-hold
+ */
+struct trace {
+    std::vector<edge>      edges;
+    std::vector<keystroke> strokes;
+    uint32_t               length;
+
+    explicit trace(int count) {
+        std::mt19937 rng(5);
+        uint32_t     t = 10;
+        for (int i = 0; i < count; i++) {
+            keystroke k = {uint8_t(rng() % MATRIX_ROWS), uint8_t(rng() % MATRIX_COLS), t, 0};
+            k.up        = t + 60 + rng() % 80;
+            // a key is only struck again once it has settled
+            bool busy = std::any_of(strokes.end() - std::min<size_t>(strokes.size(), 4), strokes.end(), [&](const keystroke &s) { return s.row == k.row && s.col == k.col; });
+            if (busy) {
+                t += 40;
+                continue;
+            }
+            bounce(k, k.down, true);
+            if (rng() % 10 == 0) {
+                uint32_t mid = k.down + 20 + rng() % 30;
+                edges.push_back({mid, k.row, k.col, false});
+                edges.push_back({mid + 1, k.row, k.col, true});
+            }
+            bounce(k, k.up, false);
+            strokes.push_back(k);
+            t += 80 + rng() % 120;
+        }
+        length = t + 200;
+        std::stable_sort(edges.begin(), edges.end(), [](const edge &a, const edge &b) { return a.ms < b.ms; });
+    }
+
+    void bounce(const keystroke &k, uint32_t at, bool closed) {
+        static std::mt19937 rng(9);
+        edges.push_back({at, k.row, k.col, closed});
+        uint32_t flips = rng() % 3 * 2;
+        for (uint32_t n = 1; n <= flips; n++) {
+            edges.push_back({at + 1 + uint32_t(rng() % 3), k.row, k.col, n % 2 ? !closed : closed});
+        }
+        // the contact ends up where it was heading
+        edges.push_back({at + 4, k.row, k.col, closed});
+    }
+};
+
+/**
+ * sym_defer_g
+ * One timer for the board: any raw change restarts it, and the cooked matrix takes the
+ * raw one once nothing changed for DEBOUNCE ms
+ */
+struct sym_defer_g {
+    uint16_t since    = 0;
+    bool     counting = false;
+
+    __attribute__((noinline)) bool operator()(matrix_row_t raw[], matrix_row_t cooked[], uint8_t rows, bool changed) {
+        if (changed) {
+            since    = timer_read();
+            counting = true;
+            return false;
+        }
+        if (counting && timer_elapsed(since) >= DEBOUNCE) {
+            counting = false;
+            bool diff = memcmp(raw, cooked, rows * sizeof(matrix_row_t)) != 0;
+            memcpy(cooked, raw, rows * sizeof(matrix_row_t));
+            return diff;
+        }
+        return false;
+    }
+};
+
+/**
+ * asym_eager_defer_pk
+ * A counter per key: a press is taken on the spot and the key then ignores the raw
+ * matrix for DEBOUNCE ms; a release waits for DEBOUNCE ms with the key open, a bounce
+ * back closed dropping the wait
+ */
+struct asym_eager_defer_pk {
+    struct counter {
+        uint8_t time; // 0 when idle
+        bool    pressed;
+    } counters[MATRIX_ROWS][MATRIX_COLS] = {};
+    uint16_t last        = 0;
+    bool     counting    = false;
+    bool     need_update = false;
+
+    __attribute__((noinline)) bool operator()(matrix_row_t raw[], matrix_row_t cooked[], uint8_t rows, bool changed) {
+        bool cooked_changed = false;
+        if (counting) {
+            uint16_t elapsed = timer_elapsed(last);
+            if (elapsed) {
+                last     = timer_read();
+                counting = false;
+                for (uint8_t row = 0; row < rows; row++) {
+                    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                        counter &c = counters[row][col];
+                        if (!c.time) {
+                            continue;
+                        }
+                        if (c.time <= elapsed) {
+                            c.time = 0;
+                            if (c.pressed) {
+                                // the cooldown is over, the key may have opened meanwhile
+                                need_update = true;
+                            } else {
+                                matrix_row_t bit = (matrix_row_t)1 << col;
+                                matrix_row_t old = cooked[row];
+                                cooked[row]      = (cooked[row] & ~bit) | (raw[row] & bit);
+                                cooked_changed |= cooked[row] != old;
+                            }
+                        } else {
+                            c.time -= elapsed;
+                            counting = true;
+                        }
+                    }
+                }
+            }
+        }
+        if (changed || need_update) {
+            need_update = false;
+            for (uint8_t row = 0; row < rows; row++) {
+                matrix_row_t delta = raw[row] ^ cooked[row];
+                for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                    counter     &c   = counters[row][col];
+                    matrix_row_t bit = (matrix_row_t)1 << col;
+                    if (delta & bit) {
+                        if (!c.time) {
+                            c.pressed = raw[row] & bit;
+                            c.time    = DEBOUNCE;
+                            if (c.pressed) {
+                                cooked[row] ^= bit;
+                                cooked_changed = true;
+                            }
+                            if (!counting) {
+                                last = timer_read();
+                            }
+                            counting = true;
+                        }
+                    } else if (c.time && !c.pressed) {
+                        // the release bounced back closed, nothing to release any more
+                        c.time = 0;
+                    }
+                }
+            }
+        }
+        return cooked_changed;
+    }
+};
+
+struct swar {
+    swar() {
+        debounce_init(MATRIX_ROWS);
+    }
+
+    __attribute__((noinline)) bool operator()(matrix_row_t raw[], matrix_row_t cooked[], uint8_t rows, bool changed) {
+        return debounce(raw, cooked, rows, changed);
+    }
+};
+
+struct result {
+    double                ns_per_scan;
+    std::vector<uint32_t> press, release;
+    uint32_t              transitions;
+};
+
+uint32_t percentile(std::vector<uint32_t> v, int percent) {
+    if (v.empty()) {
+        return 0;
+    }
+    std::sort(v.begin(), v.end());
+    return v[(v.size() - 1) * percent / 100];
+}
+
+// what the core does around the debounce call, to take off the times above; every
+// algorithm here is called out of line, as the core calls debounce()
+struct none {
+    __attribute__((noinline)) bool operator()(matrix_row_t raw[], matrix_row_t cooked[], uint8_t rows, bool changed) {
+        return false;
+    }
+};
+
+/**
+ * Replay
+ * Scans the trace SCANS_PER_MS times a millisecond with the changed flag the core would
+ * pass. The first replay records when each key changed in the cooked matrix, the rest
+ * are timed whole and the fastest counts
+ */
+template <typename D>
+double replay(const trace &tr, std::vector<std::pair<uint32_t, bool>> (*history)[MATRIX_COLS]) {
+    host_reset();
+    D            algo;
+    matrix_row_t raw[MATRIX_ROWS] = {}, last[MATRIX_ROWS] = {}, cooked[MATRIX_ROWS] = {};
+    size_t       next  = 0;
+    auto         start = std::chrono::steady_clock::now();
+
+    for (uint32_t ms = 0; ms < tr.length; ms++, host_advance(1)) {
+        for (; next < tr.edges.size() && tr.edges[next].ms == ms; next++) {
+            const edge &e = tr.edges[next];
+            raw[e.row]    = e.closed ? raw[e.row] | 1 << e.col : raw[e.row] & ~(1 << e.col);
+        }
+        for (int scan = 0; scan < SCANS_PER_MS; scan++) {
+            matrix_row_t before[MATRIX_ROWS];
+            if (history) {
+                memcpy(before, cooked, sizeof(cooked));
+            }
+            bool changed = memcmp(raw, last, sizeof(raw)) != 0;
+            memcpy(last, raw, sizeof(raw));
+            algo(raw, cooked, MATRIX_ROWS, changed);
+            sink = cooked[scan % MATRIX_ROWS];
+
+            for (uint8_t row = 0; history && row < MATRIX_ROWS; row++) {
+                for (matrix_row_t diff = before[row] ^ cooked[row]; diff; diff &= diff - 1) {
+                    uint8_t col = __builtin_ctz(diff);
+                    history[row][col].push_back({ms, cooked[row] >> col & 1});
+                }
+            }
+        }
+    }
+    std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - start;
+    return took.count() / (tr.length * SCANS_PER_MS);
+}
+
+template <typename D>
+double fastest_ns(const trace &tr) {
+    double best = 1e30;
+    for (int round = 0; round < ROUNDS; round++) {
+        best = std::min(best, replay<D>(tr, nullptr));
+    }
+    return best;
+}
+
+template <typename D>
+result measure(const trace &tr, double overhead) {
+    std::vector<std::pair<uint32_t, bool>> history[MATRIX_ROWS][MATRIX_COLS];
+    replay<D>(tr, history);
+
+    result out      = {};
+    out.ns_per_scan = fastest_ns<D>(tr) - overhead;
+    // each keystroke against the first cooked press while it was held and the first
+    // cooked release after it let go
+    for (const keystroke &k : tr.strokes) {
+        bool down = false;
+        for (auto &[ms, pressed] : history[k.row][k.col]) {
+            if (!down && pressed && ms >= k.down && ms < k.up) {
+                out.press.push_back(ms - k.down);
+                down = true;
+            } else if (down && !pressed && ms >= k.up) {
+                out.release.push_back(ms - k.up);
+                break;
+            }
+        }
+    }
+    for (auto &row : history) {
+        for (auto &key : row) {
+            out.transitions += key.size();
+        }
+    }
+    return out;
+}
+
+template <typename D>
+void report(const char *name, const trace &tr, double overhead) {
+    result r = measure<D>(tr, overhead);
+    // one press and one release per keystroke, anything more is chatter that got through
+    long leaked = long(r.transitions) - long(2 * tr.strokes.size());
+    printf("%-20s %6.1f ns/scan  press p50 %2u max %2u ms  release p50 %2u max %2u ms  chatter through %ld\n", name, r.ns_per_scan, percentile(r.press, 50), percentile(r.press, 100), percentile(r.release, 50), percentile(r.release, 100), leaked);
+}
+
+} // namespace
+
+int main() {
+    trace tr(2000);
+    printf("%zu keystrokes, %u ms, %d scans/ms, DEBOUNCE %d\n", tr.strokes.size(), tr.length, SCANS_PER_MS, DEBOUNCE);
+    double overhead = fastest_ns<none>(tr);
+    report<swar>("debounce_swar", tr, overhead);
+    report<sym_defer_g>("sym_defer_g", tr, overhead);
+    report<asym_eager_defer_pk>("asym_eager_defer_pk", tr, overhead);
+    return 0;
+}
@@ -0,0 +1,380 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <stdarg.h>
+#include <stdio.h>
+#include "harness.h"
+#include "luke.h"
+#include "send_string.h"
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+
+uint32_t host_now;
+uint32_t host_matrix_activity;
+bool     host_quiet;
+bool     host_master = true;
+
+uint8_t  host_eeprom[HOST_EEPROM_SIZE];
+uint32_t host_eeprom_writes;
+uint32_t host_eeprom_cut = UINT32_MAX;
+
+matrix_row_t host_matrix[MATRIX_ROWS];
+
+uint8_t  host_report_mods;
+uint8_t  host_report_keys[6];
+uint32_t host_reports;
+
+static report_keyboard_t report;
+report_keyboard_t       *keyboard_report = &report;
+
+layer_state_t layer_state;
+layer_state_t default_layer_state = 1;
+
+static uint8_t mods, weak_mods;
+static hsv_t   rgb_hsv;
+static uint8_t rgb_mode;
+
+// a blank EEPROM and a board that has just booted
+void host_reset(void) {
+    host_now             = 0;
+    host_matrix_activity = 0;
+    memset(host_eeprom, 0xFF, sizeof(host_eeprom));
+    host_eeprom_writes = 0;
+    host_eeprom_cut    = UINT32_MAX;
+    layer_state        = 0;
+    memset(host_matrix, 0, sizeof(host_matrix));
+    mods = weak_mods = 0;
+    clear_keys();
+    host_report_mods = 0;
+    memset(host_report_keys, 0, sizeof(host_report_keys));
+    host_reports = 0;
+}
+
+void host_advance(uint32_t ms) {
+    host_now += ms;
+}
+
+/**
+ * Timer
+ */
+uint16_t timer_read(void) {
+    return (uint16_t)host_now;
+}
+
+uint32_t timer_read32(void) {
+    return host_now;
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return TIMER_DIFF_16(timer_read(), last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return TIMER_DIFF_32(timer_read32(), last);
+}
+
+// both halves run off the one clock, as if the sync timer never drifted
+uint16_t sync_timer_read(void) {
+    return timer_read();
+}
+
+void wait_ms(uint32_t ms) {
+    host_advance(ms);
+}
+
+// whole milliseconds only, nothing here waits for less than the clock resolution
+void wait_us(uint32_t us) {
+    host_advance(us / 1000);
+}
+
+uint32_t last_matrix_activity_elapsed(void) {
+    return TIMER_DIFF_32(host_now, host_matrix_activity);
+}
+
+uint32_t last_input_activity_elapsed(void) {
+    return last_matrix_activity_elapsed();
+}
+
+matrix_row_t matrix_get_row(uint8_t row) {
+    return row < MATRIX_ROWS ? host_matrix[row] : 0;
+}
+
+/**
+ * Layers and keymap
+ */
+uint8_t get_highest_layer(layer_state_t state) {
+    return state ? 31 - __builtin_clz(state) : 0;
+}
+
+bool layer_state_is(uint8_t layer) {
+    return layer ? layer_state & (1UL << layer) : !layer_state;
+}
+
+void layer_state_set(layer_state_t state) {
+    layer_state = layer_state_set_user(state);
+}
+
+void layer_move(uint8_t layer) {
+    layer_state_set(1UL << layer);
+}
+
+void layer_on(uint8_t layer) {
+    layer_state_set(layer_state | 1UL << layer);
+}
+
+void layer_off(uint8_t layer) {
+    layer_state_set(layer_state & ~(1UL << layer));
+}
+
+void layer_clear(void) {
+    layer_state_set(0);
+}
+
+uint8_t keymap_layer_count(void) {
+    return LAYER_COUNT;
+}
+
+uint16_t keycode_at_keymap_location_raw(uint8_t layer_num, uint8_t row, uint8_t column) {
+    return layer_num < LAYER_COUNT && row < MATRIX_ROWS && column < MATRIX_COLS ? pgm_read_word(&keymaps[layer_num][row][column]) : KC_NO;
+}
+
+/**
+ * Mods and the keyboard report
+ */
+uint8_t get_mods(void) {
+    return mods;
+}
+
+void set_mods(uint8_t m) {
+    mods = m;
+}
+
+void add_mods(uint8_t m) {
+    mods |= m;
+}
+
+void del_mods(uint8_t m) {
+    mods &= ~m;
+}
+
+void clear_mods(void) {
+    mods = 0;
+}
+
+uint8_t get_weak_mods(void) {
+    return weak_mods;
+}
+
+void add_weak_mods(uint8_t m) {
+    weak_mods |= m;
+}
+
+void del_weak_mods(uint8_t m) {
+    weak_mods &= ~m;
+}
+
+void clear_weak_mods(void) {
+    weak_mods = 0;
+}
+
+uint8_t get_oneshot_mods(void) {
+    return 0;
+}
+
+void add_key(uint8_t key) {
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report.keys[i] == key) {
+            return;
+        }
+    }
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (!report.keys[i]) {
+            report.keys[i] = key;
+            return;
+        }
+    }
+}
+
+void del_key(uint8_t key) {
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report.keys[i] == key) {
+            report.keys[i] = 0;
+        }
+    }
+}
+
+void clear_keys(void) {
+    memset(report.keys, 0, sizeof(report.keys));
+}
+
+void send_keyboard_report(void) {
+    host_report_mods = mods | weak_mods;
+    memcpy(host_report_keys, report.keys, sizeof(host_report_keys));
+    host_reports++;
+}
+
+static void code16(uint16_t code, bool pressed) {
+    uint8_t code_mods = (code >> 8) & 0x1F;
+    uint8_t bits      = (code_mods & 0x10) ? (code_mods & 0x0F) << 4 : code_mods & 0x0F;
+    if (IS_MODIFIER_KEYCODE(code & 0xFF)) {
+        bits |= MOD_BIT(code & 0xFF);
+    } else if (pressed) {
+        add_key(code & 0xFF);
+    } else {
+        del_key(code & 0xFF);
+    }
+    if (pressed) {
+        add_weak_mods(bits);
+    } else {
+        del_weak_mods(bits);
+    }
+    send_keyboard_report();
+}
+
+void register_code16(uint16_t code) {
+    code16(code, true);
+}
+
+void unregister_code16(uint16_t code) {
+    code16(code, false);
+}
+
+void tap_code16(uint16_t code) {
+    register_code16(code);
+    unregister_code16(code);
+}
+
+bool is_keyboard_master(void) {
+    return host_master;
+}
+
+bool is_keyboard_left(void) {
+    return host_master;
+}
+
+// no handedness on the host, every pair is allowed to settle as a hold
+bool get_chordal_hold_default(keyrecord_t *tap_hold_record, keyrecord_t *other_record) {
+    return true;
+}
+
+/**
+ * Fake EEPROM
+ * Writes land a byte at a time until host_eeprom_cut runs out, then stop, like a board
+ * losing power part way through a flush
+ */
+void eeconfig_read_user_datablock(void *data, uint32_t offset, uint32_t length) {
+    memcpy(data, host_eeprom + offset, length);
+}
+
+void eeconfig_update_user_datablock(const void *data, uint32_t offset, uint32_t length) {
+    const uint8_t *bytes = data;
+    for (uint32_t i = 0; i < length; i++) {
+        if (host_eeprom_cut == 0) {
+            return;
+        }
+        if (host_eeprom_cut != UINT32_MAX) {
+            host_eeprom_cut--;
+        }
+        host_eeprom[offset + i] = bytes[i];
+        host_eeprom_writes++;
+    }
+}
+
+/**
+ * RGB matrix, only the state our code reads back
+ */
+#ifdef RGB_MATRIX_ENABLE
+led_config_t g_led_config;
+
+// one LED per key in matrix order, all key lights
+__attribute__((constructor)) static void led_config_init(void) {
+    uint8_t led = 0;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            g_led_config.matrix_co[row][col] = led < RGB_MATRIX_LED_COUNT ? led++ : NO_LED;
+        }
+    }
+    memset(g_led_config.flags, LED_FLAG_KEYLIGHT, sizeof(g_led_config.flags));
+}
+#endif
+
+void rgb_matrix_enable_noeeprom(void) {}
+
+void rgb_matrix_mode_noeeprom(uint8_t mode) {
+    rgb_mode = mode;
+}
+
+uint8_t rgb_matrix_get_mode(void) {
+    return rgb_mode;
+}
+
+void rgb_matrix_sethsv_noeeprom(uint8_t hue, uint8_t sat, uint8_t val) {
+    rgb_hsv = (hsv_t){hue, sat, val};
+}
+
+hsv_t rgb_matrix_get_hsv(void) {
+    return rgb_hsv;
+}
+
+uint8_t rgb_matrix_get_val(void) {
+    return rgb_hsv.v;
+}
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {}
+
+// greys only, the indicator just passes the result on
+rgb_t hsv_to_rgb(hsv_t hsv) {
+    return (rgb_t){hsv.v, hsv.v, hsv.v};
+}
+
+void qmk_printf(const char *format, ...) {
+    if (host_quiet) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+// the core task rgb_gate.c wraps, nothing to render on the host
+void __real_rgb_matrix_task(void) {}
+
+/**
+ * send_string, one key at a time as QMK sends it
+ */
+const uint8_t ascii_to_keycode_lut[128] = {
+    ['\t'] = KC_TAB, ['\n'] = KC_ENT, [' '] = KC_SPC, ['!'] = KC_1, ['"'] = KC_QUOT,
+    ['#'] = KC_3, ['$'] = KC_4, ['%'] = KC_5, ['&'] = KC_7, ['\''] = KC_QUOT,
+    ['('] = KC_9, [')'] = KC_0, ['*'] = KC_8, ['+'] = KC_EQL, [','] = KC_COMM,
+    ['-'] = KC_MINS, ['.'] = KC_DOT, ['/'] = KC_SLSH, ['0'] = KC_0, ['1'] = KC_1,
+    ['2'] = KC_2, ['3'] = KC_3, ['4'] = KC_4, ['5'] = KC_5, ['6'] = KC_6,
+    ['7'] = KC_7, ['8'] = KC_8, ['9'] = KC_9, [':'] = KC_SCLN, [';'] = KC_SCLN,
+    ['<'] = KC_COMM, ['='] = KC_EQL, ['>'] = KC_DOT, ['?'] = KC_SLSH, ['@'] = KC_2,
+    ['A'] = KC_A, ['B'] = KC_B, ['C'] = KC_C, ['D'] = KC_D, ['E'] = KC_E,
+    ['F'] = KC_F, ['G'] = KC_G, ['H'] = KC_H, ['I'] = KC_I, ['J'] = KC_J,
+    ['K'] = KC_K, ['L'] = KC_L, ['M'] = KC_M, ['N'] = KC_N, ['O'] = KC_O,
+    ['P'] = KC_P, ['Q'] = KC_Q, ['R'] = KC_R, ['S'] = KC_S, ['T'] = KC_T,
+    ['U'] = KC_U, ['V'] = KC_V, ['W'] = KC_W, ['X'] = KC_X, ['Y'] = KC_Y,
+    ['Z'] = KC_Z, ['['] = KC_LBRC, ['\\'] = KC_BSLS, [']'] = KC_RBRC, ['^'] = KC_6,
+    ['_'] = KC_MINS, ['`'] = KC_GRV, ['a'] = KC_A, ['b'] = KC_B, ['c'] = KC_C,
+    ['d'] = KC_D, ['e'] = KC_E, ['f'] = KC_F, ['g'] = KC_G, ['h'] = KC_H,
+    ['i'] = KC_I, ['j'] = KC_J, ['k'] = KC_K, ['l'] = KC_L, ['m'] = KC_M,
+    ['n'] = KC_N, ['o'] = KC_O, ['p'] = KC_P, ['q'] = KC_Q, ['r'] = KC_R,
+    ['s'] = KC_S, ['t'] = KC_T, ['u'] = KC_U, ['v'] = KC_V, ['w'] = KC_W,
+    ['x'] = KC_X, ['y'] = KC_Y, ['z'] = KC_Z, ['{'] = KC_LBRC, ['|'] = KC_BSLS,
+    ['}'] = KC_RBRC, ['~'] = KC_GRV,
+};
+
+const uint8_t ascii_to_shift_lut[16] = {0x00, 0x00, 0x00, 0x00, 0x7E, 0x0F, 0x00, 0xD4, 0xFF, 0xFF, 0xFF, 0xC7, 0x00, 0x00, 0x00, 0x78};
+
+void send_string_P(const char *string) {
+    for (; *string; string++) {
+        uint8_t ascii = *string;
+        uint8_t shift = PGM_LOADBIT(ascii_to_shift_lut, ascii) ? MOD_BIT(KC_LSFT) : 0;
+        add_weak_mods(shift);
+        add_key(ascii_to_keycode_lut[ascii]);
+        send_keyboard_report();
+        del_key(ascii_to_keycode_lut[ascii]);
+        del_weak_mods(shift);
+        send_keyboard_report();
+    }
+}
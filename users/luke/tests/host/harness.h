@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Host harness
+ * What the shims in qmk/ are backed by: a millisecond clock that only moves when the
+ * harness moves it, the EEPROM user datablock as a byte array, and the keyboard report
+ * the host would see. See tests/README.md
+ */
+extern uint32_t host_now;               // ms since boot
+extern uint32_t host_matrix_activity;   // host_now of the last matrix change
+extern bool     host_quiet;             // drop console output
+extern bool     host_master;            // is_keyboard_master()
+
+#ifndef HOST_EEPROM_SIZE
+#    define HOST_EEPROM_SIZE 1024
+#endif
+extern uint8_t  host_eeprom[HOST_EEPROM_SIZE];
+extern uint32_t host_eeprom_writes;     // bytes written so far
+extern uint32_t host_eeprom_cut;        // bytes that still reach the array, UINT32_MAX for all
+
+extern matrix_row_t host_matrix[MATRIX_ROWS]; // what matrix_get_row() returns
+
+extern uint8_t  host_report_mods;    // the last report sent
+extern uint8_t  host_report_keys[6];
+extern uint32_t host_reports;        // send_keyboard_report() calls so far
+
+void host_reset(void);
+void host_advance(uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
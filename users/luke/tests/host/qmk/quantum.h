@@ -0,0 +1,340 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+/**
+ * Host shim
+ * Just enough of QMK's API for the userspace to build and run natively, see
+ * tests/README.md. Keycode values match QMK where our code compares or decodes them;
+ * everything here is declared the way QMK declares it and implemented in harness.c
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PROGMEM
+#define pgm_read_byte(p)  (*(const uint8_t *)(p))
+#define pgm_read_word(p)  (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p)   (*(void *const *)(p))
+#define strlen_P          strlen
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define MIN(a, b)     ((a) < (b) ? (a) : (b))
+#define MAX(a, b)     ((a) > (b) ? (a) : (b))
+#define FALLTHROUGH   __attribute__((fallthrough))
+
+/* keycodes */
+
+enum qk_keycode_defines {
+    KC_NO   = 0x0000,
+    KC_TRNS = 0x0001,
+    KC_A    = 0x0004, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_M,
+    KC_N, KC_O, KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W, KC_X, KC_Y, KC_Z,
+    KC_1 = 0x001E, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0,
+    KC_ENT = 0x0028, KC_ESC, KC_BSPC, KC_TAB, KC_SPC, KC_MINS, KC_EQL, KC_LBRC, KC_RBRC, KC_BSLS,
+    KC_NUHS, KC_SCLN, KC_QUOT, KC_GRV, KC_COMM, KC_DOT, KC_SLSH,
+    KC_F1 = 0x003A, KC_F2, KC_F3, KC_F4, KC_F5, KC_F6, KC_F7, KC_F8, KC_F9, KC_F10, KC_F11, KC_F12,
+    KC_HOME = 0x004A, KC_PGUP, KC_DEL, KC_END, KC_PGDN, KC_RIGHT, KC_LEFT, KC_DOWN, KC_UP,
+    KC_EXSEL = 0x00A4,
+    KC_MUTE  = 0x00A8, KC_VOLU, KC_VOLD, KC_MNXT, KC_MPRV, KC_MSTP, KC_MPLY,
+    KC_BRIU = 0x00BD, KC_BRID,
+    MS_UP   = 0x00CD, MS_DOWN, MS_LEFT, MS_RGHT, MS_BTN1, MS_BTN2, MS_BTN3,
+    KC_LCTL = 0x00E0, KC_LSFT, KC_LALT, KC_LGUI, KC_RCTL, KC_RSFT, KC_RALT, KC_RGUI,
+    QK_BASIC_MAX     = 0x00FF,
+    QK_MODS          = 0x0100,
+    QK_MODS_MAX      = 0x1FFF,
+    QK_MOD_TAP       = 0x2000,
+    QK_MOD_TAP_MAX   = 0x3FFF,
+    QK_LAYER_TAP     = 0x4000,
+    QK_LAYER_TAP_MAX = 0x4FFF,
+    QK_TO            = 0x5200,
+    QK_MOMENTARY     = 0x5220,
+    RM_VALU          = 0x7849,
+    RM_VALD          = 0x784A,
+    QK_BOOT          = 0x7C00,
+    QK_GESC          = 0x7C16,
+    QK_USER          = 0x7E40,
+};
+
+#define KC_TRANSPARENT KC_TRNS
+#define KC_ENTER       KC_ENT
+#define KC_BACKSPACE   KC_BSPC
+#define KC_SPACE       KC_SPC
+#define KC_SLASH       KC_SLSH
+#define KC_LEFT_SHIFT  KC_LSFT
+#define KC_RIGHT_SHIFT KC_RSFT
+#define _______        KC_TRNS
+#define XXXXXXX        KC_NO
+#define SAFE_RANGE     QK_USER
+
+#define QK_LCTL 0x0100
+#define QK_LSFT 0x0200
+#define QK_LALT 0x0400
+#define QK_LGUI 0x0800
+#define LCTL(kc) (QK_LCTL | (kc))
+#define LSFT(kc) (QK_LSFT | (kc))
+#define LALT(kc) (QK_LALT | (kc))
+#define LGUI(kc) (QK_LGUI | (kc))
+#define S(kc)    LSFT(kc)
+#define LSG(kc)  (QK_LSFT | QK_LGUI | (kc))
+#define KC_MEH   LCTL(LSFT(KC_LALT))
+#define KC_HYPR  LCTL(LSFT(LALT(KC_LGUI)))
+
+#define KC_TILDE S(KC_GRV)
+#define KC_EXLM  S(KC_1)
+#define KC_AT    S(KC_2)
+#define KC_HASH  S(KC_3)
+#define KC_DLR   S(KC_4)
+#define KC_PERC  S(KC_5)
+#define KC_CIRC  S(KC_6)
+#define KC_AMPR  S(KC_7)
+#define KC_ASTR  S(KC_8)
+#define KC_LPRN  S(KC_9)
+#define KC_RPRN  S(KC_0)
+#define KC_UNDS  S(KC_MINS)
+#define KC_PLUS  S(KC_EQL)
+#define KC_LCBR  S(KC_LBRC)
+#define KC_RCBR  S(KC_RBRC)
+#define KC_PIPE  S(KC_BSLS)
+#define KC_COLN  S(KC_SCLN)
+#define KC_DQUO  S(KC_QUOT)
+#define KC_LT    S(KC_COMM)
+#define KC_GT    S(KC_DOT)
+#define KC_QUES  S(KC_SLSH)
+
+enum mods_bit {
+    MOD_LCTL = 0x01,
+    MOD_LSFT = 0x02,
+    MOD_LALT = 0x04,
+    MOD_LGUI = 0x08,
+    MOD_RCTL = 0x11,
+    MOD_RSFT = 0x12,
+    MOD_RALT = 0x14,
+    MOD_RGUI = 0x18,
+};
+
+#define MOD_BIT(code)  (1 << ((code) & 0x07))
+#define MOD_MASK_SHIFT (MOD_BIT(KC_LSFT) | MOD_BIT(KC_RSFT))
+
+#define MT(mod, kc) (QK_MOD_TAP | (((mod) & 0x1F) << 8) | ((kc) & 0xFF))
+#define LT(layer, kc) (QK_LAYER_TAP | (((layer) & 0xF) << 8) | ((kc) & 0xFF))
+#define TO(layer)   (QK_TO | ((layer) & 0x1F))
+#define MO(layer)   (QK_MOMENTARY | ((layer) & 0x1F))
+
+#define IS_BASIC_KEYCODE(code)    ((code) >= KC_A && (code) <= KC_EXSEL)
+#define IS_MODIFIER_KEYCODE(code) ((code) >= KC_LCTL && (code) <= KC_RGUI)
+#define IS_QK_MODS(code)          ((code) >= QK_MODS && (code) <= QK_MODS_MAX)
+#define IS_QK_MOD_TAP(code)       ((code) >= QK_MOD_TAP && (code) <= QK_MOD_TAP_MAX)
+#define IS_QK_LAYER_TAP(code)     ((code) >= QK_LAYER_TAP && (code) <= QK_LAYER_TAP_MAX)
+#define IS_QK_TO(code)            ((code) >= QK_TO && (code) <= QK_TO + 0x1F)
+#define IS_QK_MOMENTARY(code)     ((code) >= QK_MOMENTARY && (code) <= QK_MOMENTARY + 0x1F)
+
+#define QK_MOD_TAP_GET_MODS(kc)          (((kc) >> 8) & 0x1F)
+#define QK_MOD_TAP_GET_TAP_KEYCODE(kc)   ((kc) & 0xFF)
+#define QK_LAYER_TAP_GET_LAYER(kc)       (((kc) >> 8) & 0xF)
+#define QK_LAYER_TAP_GET_TAP_KEYCODE(kc) ((kc) & 0xFF)
+#define QK_TO_GET_LAYER(kc)              ((kc) & 0x1F)
+
+/* key events */
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef enum {
+    TICK_EVENT = 0,
+    KEY_EVENT  = 1,
+    ENCODER_CW_EVENT,
+    ENCODER_CCW_EVENT,
+    COMBO_EVENT,
+} keyevent_type_t;
+
+typedef struct {
+    keypos_t        key;
+    uint16_t        time;
+    keyevent_type_t type;
+    bool            pressed;
+} keyevent_t;
+
+typedef struct {
+    bool    interrupted : 1;
+    bool    reserved2 : 1;
+    bool    reserved1 : 1;
+    bool    reserved0 : 1;
+    uint8_t count : 4;
+} tap_t;
+
+typedef struct {
+    keyevent_t event;
+    tap_t      tap;
+    uint16_t   keycode;
+} keyrecord_t;
+
+#define MAKE_KEYEVENT(row_num, col_num, press) ((keyevent_t){.key = (keypos_t){.col = (uint8_t)(col_num), .row = (uint8_t)(row_num)}, .time = timer_read(), .type = KEY_EVENT, .pressed = (press)})
+
+/* matrix */
+
+#if MATRIX_COLS <= 8
+typedef uint8_t matrix_row_t;
+#elif MATRIX_COLS <= 16
+typedef uint16_t matrix_row_t;
+#else
+typedef uint32_t matrix_row_t;
+#endif
+
+matrix_row_t matrix_get_row(uint8_t row);
+
+/* timer, a virtual clock driven by the harness */
+
+#define TIMER_DIFF_16(a, b)               ((uint16_t)((a) - (b)))
+#define TIMER_DIFF_32(a, b)               ((uint32_t)((a) - (b)))
+#define timer_expired(current, future)    ((uint16_t)((current) - (future)) < UINT16_MAX / 2)
+#define timer_expired32(current, future)  ((uint32_t)((current) - (future)) < UINT32_MAX / 2)
+
+uint16_t timer_read(void);
+uint32_t timer_read32(void);
+uint16_t timer_elapsed(uint16_t last);
+uint32_t timer_elapsed32(uint32_t last);
+uint16_t sync_timer_read(void);
+void     wait_ms(uint32_t ms);
+void     wait_us(uint32_t us);
+
+uint32_t last_input_activity_elapsed(void);
+uint32_t last_matrix_activity_elapsed(void);
+
+/* layers and keymap */
+
+typedef uint32_t layer_state_t;
+
+#define MAX_LAYER 32
+
+extern layer_state_t layer_state;
+extern layer_state_t default_layer_state;
+
+uint8_t  get_highest_layer(layer_state_t state);
+bool     layer_state_is(uint8_t layer);
+void     layer_state_set(layer_state_t state);
+void     layer_move(uint8_t layer);
+void     layer_on(uint8_t layer);
+void     layer_off(uint8_t layer);
+void     layer_clear(void);
+uint8_t  keymap_layer_count(void);
+uint16_t keycode_at_keymap_location_raw(uint8_t layer_num, uint8_t row, uint8_t column);
+uint16_t keycode_at_keymap_location(uint8_t layer_num, uint8_t row, uint8_t column);
+
+/* actions and reports */
+
+#define KEYBOARD_REPORT_KEYS 6
+
+typedef struct {
+    uint8_t mods;
+    uint8_t reserved;
+    uint8_t keys[KEYBOARD_REPORT_KEYS];
+} report_keyboard_t;
+
+// the report being built, the host only sees it on send_keyboard_report()
+extern report_keyboard_t *keyboard_report;
+
+
+uint8_t get_mods(void);
+void    set_mods(uint8_t mods);
+void    add_mods(uint8_t mods);
+void    del_mods(uint8_t mods);
+void    clear_mods(void);
+uint8_t get_weak_mods(void);
+void    add_weak_mods(uint8_t mods);
+void    del_weak_mods(uint8_t mods);
+void    clear_weak_mods(void);
+uint8_t get_oneshot_mods(void);
+void    add_key(uint8_t key);
+void    del_key(uint8_t key);
+void    clear_keys(void);
+void    send_keyboard_report(void);
+void    register_code16(uint16_t code);
+void    unregister_code16(uint16_t code);
+void    tap_code16(uint16_t code);
+
+bool is_keyboard_master(void);
+bool is_keyboard_left(void);
+
+bool get_chordal_hold_default(keyrecord_t *tap_hold_record, keyrecord_t *other_record);
+
+/* eeconfig user datablock, a fake EEPROM */
+
+void eeconfig_read_user_datablock(void *data, uint32_t offset, uint32_t length);
+void eeconfig_update_user_datablock(const void *data, uint32_t offset, uint32_t length);
+
+/* rgb matrix, accepted and dropped */
+
+typedef struct {
+    uint8_t h, s, v;
+} hsv_t;
+
+typedef struct {
+    uint8_t r, g, b;
+} rgb_t;
+
+#define NO_LED                 255
+#define LED_FLAG_KEYLIGHT      0x04
+#define LED_FLAG_INDICATOR     0x08
+#define RGB_MATRIX_NONE        0
+#define RGB_MATRIX_SOLID_COLOR 1
+
+#ifdef RGB_MATRIX_ENABLE
+typedef struct {
+    uint8_t matrix_co[MATRIX_ROWS][MATRIX_COLS];
+    struct {
+        uint8_t x, y;
+    } point[RGB_MATRIX_LED_COUNT];
+    uint8_t flags[RGB_MATRIX_LED_COUNT];
+} led_config_t;
+
+extern led_config_t g_led_config;
+#endif
+
+void    rgb_matrix_enable_noeeprom(void);
+void    rgb_matrix_mode_noeeprom(uint8_t mode);
+uint8_t rgb_matrix_get_mode(void);
+void    rgb_matrix_sethsv_noeeprom(uint8_t hue, uint8_t sat, uint8_t val);
+hsv_t   rgb_matrix_get_hsv(void);
+uint8_t rgb_matrix_get_val(void);
+void    rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+rgb_t   hsv_to_rgb(hsv_t hsv);
+
+#ifndef RGB_MATRIX_VAL_STEP
+#    define RGB_MATRIX_VAL_STEP 16
+#endif
+#ifndef RGB_MATRIX_MAXIMUM_BRIGHTNESS
+#    define RGB_MATRIX_MAXIMUM_BRIGHTNESS 255
+#endif
+#ifndef RGB_MATRIX_LED_FLUSH_LIMIT
+#    define RGB_MATRIX_LED_FLUSH_LIMIT 16
+#endif
+
+/* user callbacks, defined in luke.c and tap_hold.c */
+
+void          keyboard_post_init_user(void);
+layer_state_t layer_state_set_user(layer_state_t state);
+bool          pre_process_record_user(uint16_t keycode, keyrecord_t *record);
+bool          process_record_user(uint16_t keycode, keyrecord_t *record);
+void          post_process_record_user(uint16_t keycode, keyrecord_t *record);
+void          housekeeping_task_user(void);
+uint16_t      get_tapping_term(uint16_t keycode, keyrecord_t *record);
+uint16_t      get_quick_tap_term(uint16_t keycode, keyrecord_t *record);
+uint16_t      get_flow_tap_term(uint16_t keycode, keyrecord_t *record, uint16_t prev_keycode);
+
+/* console, to stdout unless the harness mutes it */
+
+void qmk_printf(const char *format, ...);
+#define uprintf qmk_printf
+
+#ifdef __cplusplus
+}
+#endif
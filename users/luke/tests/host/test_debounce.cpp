@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <gtest/gtest.h>
+#include <random>
+
+extern "C" {
+#include "harness.h"
+#include "debounce.h"
+}
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+/**
+ * Chatter
+ * Raw matrix states fed to debounce_swar.c the way the core does, with changed set when
+ * the raw matrix differs from the previous scan, and the cooked matrix checked after
+ * every scan
+ */
+class Debounce : public ::testing::Test {
+   protected:
+    matrix_row_t raw[MATRIX_ROWS]    = {};
+    matrix_row_t last[MATRIX_ROWS]   = {};
+    matrix_row_t cooked[MATRIX_ROWS] = {};
+
+    void SetUp() override {
+        host_reset();
+        debounce_init(MATRIX_ROWS);
+    }
+
+    bool scan(uint32_t ms = 1) {
+        host_advance(ms);
+        bool changed = memcmp(raw, last, sizeof(raw)) != 0;
+        memcpy(last, raw, sizeof(raw));
+        return debounce(raw, cooked, MATRIX_ROWS, changed);
+    }
+
+    void set(uint8_t row, uint8_t col, bool closed) {
+        raw[row] = closed ? raw[row] | 1 << col : raw[row] & ~(1 << col);
+    }
+
+    bool down(uint8_t row, uint8_t col) {
+        return cooked[row] >> col & 1;
+    }
+};
+
+TEST_F(Debounce, PressIsReportedOnTheScanItIsFirstSeen) {
+    scan();
+    set(2, 3, true);
+    EXPECT_TRUE(scan());
+    EXPECT_TRUE(down(2, 3));
+}
+
+TEST_F(Debounce, ReleaseWaitsUntilTheKeyReadOpenForDebounceMs) {
+    set(0, 0, true);
+    scan();
+    set(0, 0, false);
+    scan();
+    for (int ms = 1; ms < DEBOUNCE; ms++) {
+        EXPECT_FALSE(scan()) << ms << " ms open";
+        EXPECT_TRUE(down(0, 0)) << ms << " ms open";
+    }
+    EXPECT_TRUE(scan());
+    EXPECT_FALSE(down(0, 0));
+}
+
+// press bounce shorter than DEBOUNCE never turns into a release and a second press
+TEST_F(Debounce, PressChatterNeverReleases) {
+    set(1, 1, true);
+    scan();
+    for (int i = 0; i < 20; i++) {
+        set(1, 1, i % 2);
+        scan();
+        EXPECT_TRUE(down(1, 1)) << "bounce " << i;
+    }
+}
+
+TEST_F(Debounce, ReleaseChatterRestartsTheTimer) {
+    set(0, 4, true);
+    scan();
+    set(0, 4, false);
+    scan(DEBOUNCE - 1);
+    set(0, 4, true);
+    scan();
+    set(0, 4, false);
+    scan();
+    scan(DEBOUNCE - 1);
+    EXPECT_TRUE(down(0, 4));
+    scan();
+    EXPECT_FALSE(down(0, 4));
+}
+
+// a long hold does not count towards the release that follows it
+TEST_F(Debounce, TimeBeforeAReleaseDoesNotCount) {
+    set(3, 2, true);
+    scan();
+    scan(1000);
+    set(3, 2, false);
+    scan();
+    EXPECT_TRUE(down(3, 2));
+    scan(DEBOUNCE - 1);
+    EXPECT_TRUE(down(3, 2));
+    scan();
+    EXPECT_FALSE(down(3, 2));
+}
+
+// the RP2040 scans several times a millisecond, scans within one tick age nothing
+TEST_F(Debounce, ScansWithinAMillisecondDoNotAge) {
+    set(5, 0, true);
+    scan();
+    set(5, 0, false);
+    scan();
+    for (int i = 0; i < 50; i++) {
+        scan(0);
+    }
+    scan(DEBOUNCE - 1);
+    EXPECT_TRUE(down(5, 0));
+    scan();
+    EXPECT_FALSE(down(5, 0));
+}
+
+// keys sharing a row keep their own timers
+TEST_F(Debounce, KeysInARowAreTimedApart) {
+    set(4, 0, true);
+    set(4, 5, true);
+    scan();
+    set(4, 0, false);
+    scan();
+    for (int ms = 1; ms < DEBOUNCE; ms++) {
+        set(4, 5, ms % 2);
+        scan();
+    }
+    scan();
+    EXPECT_FALSE(down(4, 0));
+    EXPECT_TRUE(down(4, 5));
+}
+
+// a key first seen open while another is being timed starts from zero, not from the
+// scan before, however long ago that was
+TEST_F(Debounce, KeysOpeningLaterStartTheirOwnTimer) {
+    set(2, 0, true);
+    set(2, 1, true);
+    scan();
+    set(2, 0, false);
+    scan();
+    set(2, 1, false);
+    scan(DEBOUNCE);
+    EXPECT_FALSE(down(2, 0));
+    EXPECT_TRUE(down(2, 1));
+    scan(DEBOUNCE - 1);
+    EXPECT_TRUE(down(2, 1));
+    scan();
+    EXPECT_FALSE(down(2, 1));
+}
+
+TEST_F(Debounce, IdleScansReturnStraightAway) {
+    set(6, 1, true);
+    scan();
+    for (int i = 0; i < 10; i++) {
+        EXPECT_FALSE(scan());
+    }
+}
+
+/**
+ * Reference
+ * The same rule one key at a time: down as soon as it reads closed, up once it has read
+ * open for DEBOUNCE ms in a row, counted from the scan the key was first seen open
+ */
+TEST_F(Debounce, MatchesAPerKeyModelUnderRandomChatter) {
+    std::mt19937 rng(3);
+    uint32_t     open_since[MATRIX_ROWS][MATRIX_COLS] = {};
+    bool         timing[MATRIX_ROWS][MATRIX_COLS]     = {};
+    bool         model[MATRIX_ROWS][MATRIX_COLS]      = {};
+
+    for (int i = 0; i < 200000; i++) {
+        // mostly quiet, with bursts of chatter on a few keys
+        if (rng() % 4 == 0) {
+            for (int flips = rng() % 4; flips; flips--) {
+                raw[rng() % MATRIX_ROWS] ^= 1 << (rng() % MATRIX_COLS);
+            }
+        }
+        uint32_t ms = rng() % 8 == 0 ? rng() % 4 : 1;
+        scan(ms);
+
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                bool closed = raw[row] >> col & 1;
+                if (closed) {
+                    model[row][col]  = true;
+                    timing[row][col] = false;
+                } else if (model[row][col]) {
+                    if (!timing[row][col]) {
+                        timing[row][col]     = true;
+                        open_since[row][col] = host_now;
+                    }
+                    if (host_now - open_since[row][col] >= DEBOUNCE) {
+                        model[row][col]  = false;
+                        timing[row][col] = false;
+                    }
+                }
+                ASSERT_EQ(model[row][col], down(row, col)) << "scan " << i << " row " << (int)row << " col " << (int)col;
+            }
+        }
+    }
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "harness.h"
+#include "game_mode.h"
+}
+
+/**
+ * GAME layer
+ * GAME_TAPPING_TERM is 0, so any tap-hold key GAME reaches, its own or one falling
+ * through to DFLT, could only ever be held. Every position is resolved the way the core
+ * does with GAME on top of DFLT
+ */
+static uint16_t game_keycode(uint8_t row, uint8_t col) {
+    uint16_t keycode = keycode_at_keymap_location_raw(GAME, row, col);
+    return keycode == KC_TRNS ? keycode_at_keymap_location_raw(DFLT, row, col) : keycode;
+}
+
+TEST(GameMode, EveryKeyTypesOnTap) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint16_t keycode = game_keycode(row, col);
+            EXPECT_FALSE(IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode)) << "row " << +row << " col " << +col << " is tap-hold 0x" << std::hex << keycode;
+        }
+    }
+}
+
+// TO(DFLT) lives on SYS, the way back out of GAME
+TEST(GameMode, SysIsReachable) {
+    bool found = false;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            found |= game_keycode(row, col) == MO(SYS);
+        }
+    }
+    EXPECT_TRUE(found);
+}
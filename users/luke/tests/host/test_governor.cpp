@@ -0,0 +1,360 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <gtest/gtest.h>
+#include <ucontext.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "harness.h"
+#include "governor.h"
+#include "sched.h"
+
+// the same governor.c built twice, see the Makefile: the master's sleeps yield to the
+// other half, the slave's copy has its globals and everything it calls renamed slave_*
+void    slave_governor_task(void);
+uint8_t slave_governor_state(void);
+void    slave_governor_sync(uint8_t master_state);
+}
+
+/**
+ * Virtual clock
+ * Both halves run their main loop as coroutines on their own microsecond clocks, and
+ * whichever is behind runs next, so a sleep on one half lets the other carry on. A pass
+ * is a 150 us matrix scan, then housekeeping: sched_task, the split sync when the
+ * master's governor state changed, and governor_task last, whose sleeps are the only
+ * other time that passes. Each half's matrix is debounced the way debounce_swar.c does
+ * it, a press on the scan that sees it and a release once the key has read open for
+ * DEBOUNCE ms, and the master reads the slave's rows as the slave's last finished scan
+ * left them.
+ */
+namespace {
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+constexpr uint32_t SCAN_US = 150;
+constexpr uint32_t TAP_US  = 5000;
+constexpr uint8_t  HALF    = MATRIX_ROWS / 2;
+constexpr size_t   STACK   = 64 * 1024;
+
+struct press {
+    bool     slave;
+    uint8_t  row, col; // within the half
+    uint64_t down, up; // us
+    uint64_t half_seen   = 0; // the scan of its own half that saw it
+    uint64_t master_seen = 0; // the master scan that saw it, through the link for the slave
+};
+
+struct rows {
+    matrix_row_t cooked[HALF];
+    uint64_t     opened[HALF][MATRIX_COLS]; // first scan that read a down key open
+};
+
+struct half {
+    ucontext_t        context;
+    std::vector<char> stack       = std::vector<char>(STACK);
+    uint64_t          us          = 0;
+    rows              matrix      = {};
+    uint64_t          activity_us = 0; // the slave's last matrix change
+};
+
+ucontext_t            scheduler;
+half                  master, slave;
+half                 *running;
+std::vector<press>    presses;
+std::vector<uint64_t> slave_passes; // start of every slave pass
+std::vector<uint64_t> wake_syncs;   // master syncs that woke the slave up
+uint8_t               synced = GOV_ACTIVE;
+void                (*on_housekeeping)(void); // the test's own work on the master, once
+
+void advance(uint64_t us) {
+    running->us += us;
+    swapcontext(&running->context, &scheduler);
+    host_now = master.us / 1000;
+}
+
+// debounces one half's keys as a scan at the given time reads them, true on a change
+bool scan(rows &h, uint64_t now, bool is_slave) {
+    matrix_row_t raw[HALF] = {};
+    for (press &p : presses) {
+        if (p.slave == is_slave && p.down <= now && now < p.up) {
+            raw[p.row] |= 1 << p.col;
+        }
+    }
+    bool changed = false;
+    for (uint8_t r = 0; r < HALF; r++) {
+        matrix_row_t pressed = raw[r] & ~h.cooked[r];
+        matrix_row_t open    = h.cooked[r] & ~raw[r];
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            matrix_row_t bit = 1 << col;
+            if (!(open & bit)) {
+                h.opened[r][col] = 0;
+            } else if (!h.opened[r][col]) {
+                h.opened[r][col] = now;
+            } else if (now - h.opened[r][col] >= DEBOUNCE * 1000) {
+                h.cooked[r] &= ~bit;
+                h.opened[r][col] = 0;
+                changed          = true;
+            }
+        }
+        if (pressed) {
+            h.cooked[r] |= pressed;
+            changed = true;
+        }
+    }
+    for (press &p : presses) {
+        if (p.slave == is_slave && !p.half_seen && now >= p.down && h.cooked[p.row] >> p.col & 1) {
+            p.half_seen = now;
+        }
+    }
+    return changed;
+}
+
+void master_loop() {
+    for (;;) {
+        matrix_row_t before[MATRIX_ROWS];
+        memcpy(before, host_matrix, sizeof(before));
+        scan(master.matrix, master.us, false);
+        // the slave's rows from its last finished scan
+        memcpy(host_matrix, master.matrix.cooked, sizeof(master.matrix.cooked));
+        memcpy(&host_matrix[HALF], slave.matrix.cooked, sizeof(slave.matrix.cooked));
+        if (memcmp(before, host_matrix, sizeof(before))) {
+            host_matrix_activity = host_now;
+        }
+        for (press &p : presses) {
+            uint8_t row = p.slave ? HALF + p.row : p.row;
+            if (!p.master_seen && master.us >= p.down && host_matrix[row] >> p.col & 1) {
+                p.master_seen = master.us;
+            }
+        }
+        advance(SCAN_US);
+
+        if (on_housekeeping) {
+            on_housekeeping();
+            on_housekeeping = nullptr;
+        }
+        sched_task();
+        if (governor_state() != synced) {
+            synced = governor_state();
+            if (synced < slave_governor_state()) {
+                wake_syncs.push_back(master.us);
+            }
+            slave_governor_sync(synced);
+        }
+        governor_task();
+    }
+}
+
+void slave_loop() {
+    for (;;) {
+        slave_passes.push_back(slave.us);
+        // the scan reads the keys as they are when it starts, and the master only sees
+        // its rows once it is over
+        rows     next    = slave.matrix;
+        uint64_t start   = slave.us;
+        bool     changed = scan(next, start, true);
+        advance(SCAN_US);
+        slave.matrix = next;
+        if (changed) {
+            slave.activity_us = start;
+        }
+        slave_governor_task();
+    }
+}
+
+void start(half &h, void (*loop)()) {
+    getcontext(&h.context);
+    h.context.uc_stack.ss_sp   = h.stack.data();
+    h.context.uc_stack.ss_size = h.stack.size();
+    h.context.uc_link          = &scheduler;
+    makecontext(&h.context, loop, 0);
+}
+
+// runs both halves until both clocks reach the given time
+void run_until(uint64_t us) {
+    while (master.us < us || slave.us < us) {
+        running = slave.us < master.us ? &slave : &master;
+        swapcontext(&scheduler, &running->context);
+    }
+}
+
+// the time since the last matrix change on each half, as if both had been quiet that long
+void quiet_for(uint32_t ms) {
+    host_matrix_activity = host_now - ms;
+    slave.activity_us    = slave.us - ms * 1000ull;
+}
+
+uint64_t percentile(std::vector<uint64_t> v, int percent) {
+    if (v.empty()) {
+        return 0;
+    }
+    std::sort(v.begin(), v.end());
+    return v[(v.size() - 1) * percent / 100];
+}
+
+} // namespace
+
+// what the slave's governor.c reads, off the slave's clock and matrix
+extern "C" {
+uint32_t slave_timer_read32(void) {
+    return slave.us / 1000;
+}
+
+void slave_wait_ms(uint32_t ms) {
+    advance(ms * 1000ull);
+}
+
+void master_wait_ms(uint32_t ms) {
+    advance(ms * 1000ull);
+}
+
+uint32_t slave_last_input_activity_elapsed(void) {
+    return (slave.us - slave.activity_us) / 1000;
+}
+
+matrix_row_t slave_matrix_get_row(uint8_t row) {
+    return row >= HALF && row < MATRIX_ROWS ? slave.matrix.cooked[row - HALF] : 0;
+}
+
+bool slave_is_keyboard_master(void) {
+    return false;
+}
+
+// nothing on the slave arms the scheduler
+uint32_t slave_sched_due_in(void) {
+    return UINT32_MAX;
+}
+}
+
+class Governor : public ::testing::Test {
+   protected:
+    std::mt19937 rng{11};
+
+    void SetUp() override {
+        host_reset();
+        host_quiet = true;
+        master     = half();
+        slave      = half();
+        presses.clear();
+        slave_passes.clear();
+        wake_syncs.clear();
+        synced          = GOV_ACTIVE;
+        on_housekeeping = nullptr;
+        start(master, master_loop);
+        start(slave, slave_loop);
+    }
+
+    uint64_t now() {
+        return std::max(master.us, slave.us);
+    }
+
+    // settles both halves into the given state, then taps a random key somewhere in the
+    // next few ms and runs on until it is released and debounced
+    press &tap(uint8_t state, bool on_slave) {
+        quiet_for(state == GOV_DEEP ? GOVERNOR_DEEP_MS + 1000 : state == GOV_IDLE ? GOVERNOR_IDLE_MS + 1000 : 0);
+        run_until(now() + 20000);
+        EXPECT_EQ(state, governor_state());
+        EXPECT_EQ(state, slave_governor_state());
+
+        press p = {on_slave, uint8_t(rng() % HALF), uint8_t(rng() % MATRIX_COLS), 0, 0};
+        p.down  = now() + rng() % 10000;
+        p.up    = p.down + TAP_US;
+        presses.push_back(p);
+        run_until(p.up + DEBOUNCE * 1000 + 20000);
+        return presses.back();
+    }
+};
+
+// press to the scan that sees it, on its own half and on the master, for each state the
+// halves can be in; printed for the README and checked against one sleep plus a scan
+TEST_F(Governor, PressLatencyPerState) {
+    const char *names[] = {"active", "idle", "deep"};
+    uint32_t    periods[] = {0, GOVERNOR_IDLE_PERIOD_MS, GOVERNOR_DEEP_PERIOD_MS};
+
+    printf("%-7s %-24s %-24s %s\n", "state", "master key to scan", "slave key to slave scan", "slave key to master scan");
+    for (uint8_t state = GOV_ACTIVE; state < GOV_STATE_COUNT; state++) {
+        std::vector<uint64_t> master_keys, slave_keys, slave_to_master;
+        for (int i = 0; i < 200; i++) {
+            press p = tap(state, i % 2);
+            ASSERT_TRUE(p.master_seen) << names[state] << " tap " << i << " lost";
+            if (p.slave) {
+                slave_keys.push_back(p.half_seen - p.down);
+                slave_to_master.push_back(p.master_seen - p.down);
+            } else {
+                master_keys.push_back(p.master_seen - p.down);
+            }
+        }
+        uint64_t bound = periods[state] * 1000 + SCAN_US;
+        EXPECT_LE(percentile(master_keys, 100), bound) << names[state];
+        EXPECT_LE(percentile(slave_keys, 100), bound) << names[state];
+        EXPECT_LE(percentile(slave_to_master, 100), 2 * bound + SCAN_US) << names[state];
+        printf("%-7s p50 %4.2f max %4.2f ms     p50 %4.2f max %4.2f ms     p50 %4.2f max %4.2f ms\n", names[state], percentile(master_keys, 50) / 1e3, percentile(master_keys, 100) / 1e3, percentile(slave_keys, 50) / 1e3, percentile(slave_keys, 100) / 1e3, percentile(slave_to_master, 50) / 1e3, percentile(slave_to_master, 100) / 1e3);
+    }
+}
+
+// a slave key in deep idle brings both halves back to full rate
+TEST_F(Governor, APressWakesBothHalves) {
+    press p = tap(GOV_DEEP, true);
+    EXPECT_TRUE(p.master_seen);
+    run_until(now() + 1000);
+    EXPECT_EQ(GOV_ACTIVE, governor_state());
+    EXPECT_EQ(GOV_ACTIVE, slave_governor_state());
+}
+
+// a master key wakes the master, and its sync cuts the slave's sleep short
+TEST_F(Governor, SlaveWakesWithinAMillisecondOfTheSync) {
+    std::vector<uint64_t> wakes;
+    for (int i = 0; i < 100; i++) {
+        tap(i % 2 ? GOV_DEEP : GOV_IDLE, false);
+        for (uint64_t sync : wake_syncs) {
+            auto next = std::lower_bound(slave_passes.begin(), slave_passes.end(), sync);
+            ASSERT_NE(next, slave_passes.end());
+            wakes.push_back(*next - sync);
+        }
+        wake_syncs.clear();
+    }
+    ASSERT_FALSE(wakes.empty());
+    EXPECT_LE(percentile(wakes, 100), 1000u);
+    printf("slave back to full rate p50 %.2f max %.2f ms after the master's sync\n", percentile(wakes, 50) / 1e3, percentile(wakes, 100) / 1e3);
+}
+
+// sleeps stop at the next scheduler deadline, so a flush armed in deep idle runs on time
+namespace {
+uint32_t flush_delay;
+uint64_t flush_due_us, flush_ran_us;
+
+uint32_t flush(void) {
+    flush_ran_us = master.us;
+    return 0;
+}
+
+// as a brightness change over raw HID would, between two scans
+void arm_flush(void) {
+    flush_due_us = (uint64_t)(host_now + flush_delay) * 1000;
+    sched_arm(SCHED_SETTINGS_FLUSH, flush_delay, flush);
+}
+} // namespace
+
+TEST_F(Governor, DeepIdleSleepsStopAtTheNextDeadline) {
+    quiet_for(GOVERNOR_DEEP_MS + 1000);
+    run_until(now() + 20000);
+    ASSERT_EQ(GOV_DEEP, governor_state());
+
+    std::vector<uint64_t> late;
+    for (int i = 0; i < 200; i++) {
+        run_until(now() + rng() % 5000);
+        flush_delay     = 1 + rng() % 50;
+        flush_ran_us    = 0;
+        on_housekeeping = arm_flush;
+        run_until(now() + (flush_delay + 10) * 1000ull);
+        ASSERT_TRUE(flush_ran_us) << "flush " << i;
+        late.push_back(flush_ran_us > flush_due_us ? flush_ran_us - flush_due_us : 0);
+    }
+    EXPECT_EQ(GOV_DEEP, governor_state());
+    // deadlines are whole milliseconds and sched_task runs after the scan
+    EXPECT_LE(percentile(late, 100), 1000u + SCAN_US);
+    printf("flush armed in deep idle ran p50 %.2f max %.2f ms past its deadline\n", percentile(late, 50) / 1e3, percentile(late, 100) / 1e3);
+}
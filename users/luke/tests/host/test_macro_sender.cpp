@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+
+extern "C" {
+#include "harness.h"
+#include "macro_sender.h"
+#include "send_string.h"
+}
+
+/**
+ * Macro playback
+ * macro_sender.c played from housekeeping a polling interval at a time, with a host that
+ * types each key the moment it first shows up in a report, in report order, shifted if
+ * the report carries shift
+ */
+class MacroSender : public ::testing::Test {
+   protected:
+    std::map<std::pair<uint8_t, bool>, char> chars;
+    uint8_t                                  seen[6] = {};
+    std::string                              typed;
+
+    void SetUp() override {
+        host_reset();
+        host_quiet = true;
+        for (int ascii = 1; ascii < 128; ascii++) {
+            uint8_t keycode = ascii_to_keycode_lut[ascii];
+            if (keycode) {
+                chars.emplace(std::make_pair(keycode, (bool)PGM_LOADBIT(ascii_to_shift_lut, ascii)), ascii);
+            }
+        }
+    }
+
+    void host_reads() {
+        bool shift = host_report_mods & MOD_BIT(KC_LSFT);
+        for (uint8_t key : host_report_keys) {
+            if (key && std::find(std::begin(seen), std::end(seen), key) == std::end(seen)) {
+                auto found = chars.find({key, shift});
+                typed += found == chars.end() ? '?' : found->second;
+            }
+        }
+        memcpy(seen, host_report_keys, sizeof(seen));
+    }
+
+    // one task per millisecond until the macro is done or the time runs out
+    void play_for(uint32_t ms) {
+        for (uint32_t t = 0; t < ms && macro_sender_busy(); t++) {
+            host_advance(1);
+            uint32_t before = host_reports;
+            macro_sender_task();
+            if (host_reports != before) {
+                host_reads();
+            }
+        }
+    }
+};
+
+TEST_F(MacroSender, TypesEveryMacroExactly) {
+    const char *texts[] = {"->", "=>", "TODO(luke): ", "qmk compile -km luke\n"};
+    ASSERT_EQ(ARRAY_SIZE(texts), (size_t)MACRO_COUNT);
+
+    for (uint8_t macro = 0; macro < MACRO_COUNT; macro++) {
+        typed.clear();
+        uint32_t reports = host_reports;
+        macro_sender_play(macro);
+        play_for(1000);
+        EXPECT_FALSE(macro_sender_busy());
+        EXPECT_EQ(typed, texts[macro]);
+        EXPECT_EQ(host_report_mods, 0) << texts[macro] << " left shift on";
+        // a press and a release per chunk, fewer than a report per key once packed
+        if (MACRO_KEYS_PER_REPORT > 1 && strlen(texts[macro]) > 4) {
+            EXPECT_LT(host_reports - reports, 2 * strlen(texts[macro])) << texts[macro] << " went out a key at a time";
+        }
+    }
+}
+
+// the second O of TODO was in the report already, its own chunk's, and used to be dropped
+TEST_F(MacroSender, RepeatedKeyEndsTheChunk) {
+    macro_sender_play(MC_TODO_ID);
+    play_for(1000);
+    EXPECT_EQ(typed, "TODO(luke): ");
+}
+
+/**
+ * Held key
+ * The user holds O while TODO plays: the macro stops before its first O and waits, the
+ * keys before it out, and finishes once O is let go
+ */
+TEST_F(MacroSender, HeldKeyWaitsForTheRelease) {
+    add_key(KC_O);
+    send_keyboard_report();
+    host_reads();
+    typed.clear();
+
+    macro_sender_play(MC_TODO_ID);
+    play_for(50);
+    EXPECT_TRUE(macro_sender_busy());
+    EXPECT_EQ(typed, "T");
+    EXPECT_TRUE(std::find(std::begin(host_report_keys), std::end(host_report_keys), KC_O) != std::end(host_report_keys)) << "the held O was released under the user";
+
+    del_key(KC_O);
+    send_keyboard_report();
+    host_reads();
+    play_for(1000);
+    EXPECT_FALSE(macro_sender_busy());
+    EXPECT_EQ(typed, "TODO(luke): ");
+}
@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <gtest/gtest.h>
+#include <vector>
+
+extern "C" {
+#include "harness.h"
+#include "remap.h"
+#include "sched.h"
+}
+
+/**
+ * Remap table
+ * remap.c against the fake EEPROM: edits through the raw hid commands, flushes through
+ * the scheduler, and boots through remap_init reading back whatever the EEPROM holds,
+ * including a flush that lost power part way
+ */
+class Remap : public ::testing::Test {
+   protected:
+    typedef std::vector<uint16_t> keymap_t;
+
+    void SetUp() override {
+        host_reset();
+        host_quiet = true;
+        remap_init();
+    }
+
+    uint8_t raw(uint8_t command, uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint16_t keycode = 0) {
+        uint8_t data[32] = {command, 0, a, b, c, uint8_t(keycode & 0xFF), uint8_t(keycode >> 8)};
+        remap_raw(data, sizeof(data));
+        last_info = {data[5], data[6]};
+        return data[1];
+    }
+
+    uint8_t set(uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode) {
+        return raw(RAW_REMAP_SET, layer, row, col, keycode);
+    }
+
+    // the remapped keys and the capacity, as RAW_REMAP_INFO reports them
+    std::pair<uint8_t, uint8_t> info() {
+        raw(RAW_REMAP_INFO);
+        return last_info;
+    }
+
+    void flush() {
+        host_advance(REMAP_FLUSH_MS);
+        sched_task();
+        ASSERT_FALSE(sched_is_armed(SCHED_REMAP_FLUSH));
+    }
+
+    keymap_t keymap() {
+        keymap_t keys;
+        for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                    keys.push_back(remap_keycode(layer, row, col));
+                }
+            }
+        }
+        return keys;
+    }
+
+    std::pair<uint8_t, uint8_t> last_info;
+};
+
+TEST_F(Remap, EditsSurviveARestart) {
+    EXPECT_EQ(set(0, 1, 2, KC_Q), REMAP_OK);
+    EXPECT_EQ(set(1, MATRIX_ROWS - 1, MATRIX_COLS - 1, KC_F12), REMAP_OK);
+    EXPECT_EQ(set(LAYER_COUNT, 0, 0, KC_A), REMAP_BAD_POSITION);
+    flush();
+
+    remap_init();
+    EXPECT_EQ(remap_keycode(0, 1, 2), KC_Q);
+    EXPECT_EQ(remap_keycode(1, MATRIX_ROWS - 1, MATRIX_COLS - 1), KC_F12);
+    EXPECT_EQ(info().first, 2);
+}
+
+TEST_F(Remap, EditsInOneWindowFlushTogether) {
+    set(0, 0, 0, KC_Q);
+    host_advance(REMAP_FLUSH_MS - 1);
+    sched_task();
+    set(0, 0, 1, KC_W);
+    EXPECT_EQ(host_eeprom_writes, 0u) << "flushed before the window closed";
+
+    host_advance(1);
+    sched_task();
+    uint32_t first = host_eeprom_writes;
+    EXPECT_GT(first, 0u);
+    host_advance(REMAP_FLUSH_MS);
+    sched_task();
+    EXPECT_EQ(host_eeprom_writes, first) << "the second edit took a flush of its own";
+
+    remap_init();
+    EXPECT_EQ(remap_keycode(0, 0, 0), KC_Q);
+    EXPECT_EQ(remap_keycode(0, 0, 1), KC_W);
+}
+
+TEST_F(Remap, ResetRestoresTheKeymap) {
+    keymap_t defaults = keymap();
+    set(0, 2, 2, KC_Z);
+    set(1, 2, 2, KC_Z);
+    flush();
+
+    raw(RAW_REMAP_RESET, 0xFF);
+    EXPECT_EQ(keymap(), defaults);
+    EXPECT_EQ(info().first, 0);
+    flush();
+    remap_init();
+    EXPECT_EQ(keymap(), defaults);
+}
+
+TEST_F(Remap, FullTableRefusesNewKeysButTakesEdits) {
+    uint8_t capacity = info().second;
+    ASSERT_GT(capacity, 0);
+    ASSERT_LT(capacity, LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS);
+
+    // a keycode no layer has anywhere, so every edit is a remapped key
+    const uint16_t base  = 0x7E40;
+    uint16_t       count = 0;
+    for (uint8_t layer = 0; layer < LAYER_COUNT && count < capacity; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS && count < capacity; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS && count < capacity; col++) {
+                ASSERT_EQ(set(layer, row, col, base + count), REMAP_OK) << count;
+                count++;
+            }
+        }
+    }
+    EXPECT_EQ(info().first, capacity);
+    EXPECT_EQ(set(LAYER_COUNT - 1, MATRIX_ROWS - 1, MATRIX_COLS - 1, KC_Q), REMAP_FULL);
+    EXPECT_EQ(set(0, 0, 0, KC_Q), REMAP_OK) << "an already remapped key can still change";
+
+    flush();
+    remap_init();
+    EXPECT_EQ(info().first, capacity);
+    EXPECT_EQ(remap_keycode(0, 0, 0), KC_Q);
+}
+
+// generations wrap at 256, the newer region has to win across the wrap
+TEST_F(Remap, NewestTableWinsAcrossGenerationWrap) {
+    for (int i = 0; i < 600; i++) {
+        set(0, 0, 0, 0x7E00 + i % 7);
+        flush();
+        remap_init();
+        ASSERT_EQ(remap_keycode(0, 0, 0), 0x7E00 + i % 7) << "flush " << i;
+    }
+}
+
+/**
+ * Torn flush
+ * Power cut after every byte count of a flush in turn, then a boot: the board comes back
+ * with the table from before the flush or the one it was writing, never the defaults or
+ * a mix. The flush overwrites the region that held the table before last, so a write
+ * that lands over it cannot take the last table with it.
+ */
+TEST_F(Remap, PowerLostMidFlushKeepsTheOldTableOrTheNew) {
+    keymap_t defaults = keymap();
+    set(0, 0, 0, KC_Q);
+    set(0, 0, 1, KC_W);
+    set(1, 3, 4, KC_F1);
+    flush();
+    set(0, 0, 1, KC_E);
+    set(1, 2, 2, KC_F2);
+    flush();
+
+    std::vector<uint8_t> before(host_eeprom, host_eeprom + HOST_EEPROM_SIZE);
+    remap_init();
+    keymap_t old = keymap();
+
+    auto edit = [&] {
+        set(0, 0, 0, defaults[0]);
+        set(0, 0, 1, KC_R);
+        set(0, 1, 1, KC_T);
+        set(1, 2, 2, KC_F3);
+    };
+    edit();
+    keymap_t wanted = keymap();
+    ASSERT_NE(wanted, old);
+    uint32_t start = host_eeprom_writes;
+    flush();
+    uint32_t length = host_eeprom_writes - start;
+
+    bool saw_old = false, saw_new = false;
+    for (uint32_t cut = 0; cut <= length; cut++) {
+        std::copy(before.begin(), before.end(), host_eeprom);
+        remap_init();
+        edit();
+        host_eeprom_cut = cut;
+        flush();
+        host_eeprom_cut = UINT32_MAX;
+
+        remap_init();
+        keymap_t booted = keymap();
+        ASSERT_TRUE(booted == old || booted == wanted) << "power lost " << cut << " of " << length << " bytes in";
+        if (cut == length) {
+            EXPECT_EQ(booted, wanted);
+        }
+        saw_old |= booted == old;
+        saw_new |= booted == wanted;
+
+        // and the next flush after the boot lands whole
+        edit();
+        flush();
+        remap_init();
+        ASSERT_EQ(keymap(), wanted) << "flush after a cut at " << cut;
+    }
+    EXPECT_TRUE(saw_old && saw_new);
+}
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+extern "C" {
+#include "harness.h"
+#include "split_probe.h"
+#include "transactions.h"
+
+// the same split_probe.c built a second time with its globals renamed, see the Makefile,
+// so both halves run in one process with their own state
+void slave_split_probe_init(void);
+void slave_split_probe_slave_scan(void);
+}
+
+/**
+ * Two halves
+ * The master is the left half and reads the slave's rows 4-7 from the harness matrix, as
+ * the core would have put them there; the slave scans its own rows, which are the
+ * right half of its matrix. The link between them can lose requests and replies.
+ */
+namespace {
+
+constexpr uint8_t HALF = SPLIT_PROBE_ROWS;
+
+matrix_row_t     slave_rows[HALF];
+slave_callback_t slave_handler;
+
+struct {
+    double          lose_request = 0, lose_reply = 0;
+    std::mt19937    rng{1};
+    bool            last_ok = false;
+    uint32_t        served  = 0;
+
+    bool lost(double chance) {
+        return std::uniform_real_distribution<>(0, 1)(rng) < chance;
+    }
+} wire;
+
+} // namespace
+
+extern "C" {
+bool slave_is_keyboard_master(void) {
+    return false;
+}
+
+bool slave_is_keyboard_left(void) {
+    return false;
+}
+
+matrix_row_t slave_matrix_get_row(uint8_t row) {
+    return row >= HALF && row < MATRIX_ROWS ? slave_rows[row - HALF] : 0;
+}
+
+void slave_transaction_register_rpc(int8_t id, slave_callback_t callback) {
+    if (id == USER_SPLIT_PROBE) {
+        slave_handler = callback;
+    }
+}
+
+// the slave never starts a transaction
+bool slave_transaction_rpc_exec(int8_t id, uint8_t in_len, const void *in, uint8_t out_len, void *out) {
+    return false;
+}
+
+// the master registers its handler too, for the role it never takes here
+void transaction_register_rpc(int8_t id, slave_callback_t callback) {}
+
+bool transaction_rpc_exec(int8_t id, uint8_t in_len, const void *in, uint8_t out_len, void *out) {
+    wire.last_ok = false;
+    if (id != USER_SPLIT_PROBE || !slave_handler || wire.lost(wire.lose_request)) {
+        return false;
+    }
+    slave_handler(in_len, in, out_len, out);
+    if (wire.lost(wire.lose_reply)) {
+        return false;
+    }
+    wire.last_ok = true;
+    wire.served++;
+    return true;
+}
+}
+
+class SplitProbe : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        host_reset();
+        host_quiet = true;
+        memset(slave_rows, 0, sizeof(slave_rows));
+        wire.lose_request = wire.lose_reply = 0;
+        wire.served                         = 0;
+        split_probe_init();
+        slave_split_probe_init();
+    }
+
+    // one scan on both halves: the slave scans, then the master, whose core has read the
+    // slave rows whenever the test put them there
+    void scan() {
+        slave_split_probe_slave_scan();
+        split_probe_scan();
+        host_advance(1);
+    }
+
+    void core_sees(const matrix_row_t *rows) {
+        memcpy(&host_matrix[HALF], rows, HALF * sizeof(matrix_row_t));
+    }
+
+    void press_event(uint8_t row, uint8_t col) {
+        keyrecord_t record = {};
+        record.event       = MAKE_KEYEVENT(HALF + row, col, true);
+        record.event.time  = timer_read();
+        split_probe_event(&record);
+    }
+
+    // press on the slave, the core delivers it after a scan, the event follows
+    void tap(uint8_t row, uint8_t col) {
+        matrix_row_t pressed[HALF] = {};
+        pressed[row]               = 1 << col;
+        slave_rows[row]            = pressed[row];
+        scan();
+        scan();
+        core_sees(pressed);
+        scan();
+        press_event(row, col);
+
+        slave_rows[row] = pressed[row] = 0;
+        core_sees(pressed);
+        for (int j = 0; j < 20; j++) {
+            scan();
+        }
+    }
+
+    std::string report() {
+        host_quiet = false;
+        testing::internal::CaptureStdout();
+        split_probe_report();
+        host_quiet = true;
+        return testing::internal::GetCapturedStdout();
+    }
+};
+
+// slave press to master key event, here three scans behind the slave for the core's read
+TEST_F(SplitProbe, TimesSlavePresses) {
+    for (int i = 0; i < 10; i++) {
+        tap(1, 2);
+    }
+    EXPECT_NE(report().find("10 presses, p50 4 ms, p99 4 ms, max 3 ms"), std::string::npos) << report();
+}
+
+// the keymap has the core's rows, so with nothing newly pressed the link stays quiet
+TEST_F(SplitProbe, FetchesOnlyForNewPresses) {
+    for (int i = 0; i < 1000; i++) {
+        scan();
+    }
+    EXPECT_EQ(wire.served, 0u);
+
+    tap(0, 0);
+    tap(3, 5);
+    EXPECT_EQ(wire.served, 2u);
+}
+
+// a press whose fetch was lost goes untimed, the ones that got through keep their delay
+TEST_F(SplitProbe, LostFetchesLeavePressesUntimed) {
+    wire.lose_request = wire.lose_reply = 0.3;
+    for (int i = 0; i < 100; i++) {
+        tap(i % HALF, i % MATRIX_COLS);
+    }
+    EXPECT_NE(report().find("100 fetches"), std::string::npos) << report();
+    EXPECT_NE(report().find(std::to_string(wire.served) + " presses, p50 4 ms, p99 4 ms, max 3 ms"), std::string::npos) << report();
+}
+
+// more presses in one scan than a reply holds take more fetches in that scan
+TEST_F(SplitProbe, StampsABurstInOneScan) {
+    matrix_row_t all[HALF];
+    for (uint8_t r = 0; r < HALF; r++) {
+        all[r] = slave_rows[r] = (1 << MATRIX_COLS) - 1;
+    }
+    scan();
+    core_sees(all);
+    scan();
+    for (uint8_t r = 0; r < HALF; r++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            press_event(r, col);
+        }
+    }
+    EXPECT_EQ(wire.served, (HALF * MATRIX_COLS + SPLIT_PROBE_MAX_PRESSES - 1) / SPLIT_PROBE_MAX_PRESSES);
+    EXPECT_NE(report().find(std::to_string(HALF * MATRIX_COLS) + " presses"), std::string::npos) << report();
+}
+
+// keys the master already knew about before it could stamp them are not timed
+TEST_F(SplitProbe, SkipsPressesItHasNoStampFor) {
+    press_event(0, 0);
+    EXPECT_NE(report().find("0 presses"), std::string::npos);
+}
@@ -0,0 +1,6 @@
+# the userspace the traces run through on top of the core: the board's keymap.c, our
+# tap-hold callbacks and the latency histograms; LUKE_USER and LUKE_TEST are set by
+# tools/qmk_tests.py, which stages this suite once per qmk.json target
+SRC += $(LUKE_TEST)/luke_keymap.c $(LUKE_USER)/tap_hold.c $(LUKE_USER)/game_mode.c $(LUKE_USER)/latency.c
+# quoted includes only, our sched.h would shadow the system one gtest pulls in
+OPT_DEFS += -iquote $(LUKE_USER) -DLATENCY_ENABLE
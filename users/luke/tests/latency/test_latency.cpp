@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "replay.hpp"
+
+extern "C" {
+#include "latency.h"
+#include "game_mode.h"
+#include "tap_hold.h"
+
+// what luke.c does in these for the modules compiled in
+layer_state_t layer_state_set_user(layer_state_t state) {
+    return game_mode_layer_state(state);
+}
+
+void post_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    latency_record(keycode, record);
+}
+}
+
+class Latency : public ReplayFixture {};
+
+static void print_hist(const char *name, const char *what, const latency_hist_t *hist) {
+    printf("%-28s %-8s n=%5u p50=%3u p99=%3u max=%3u\n", name, what, hist->count, latency_percentile(hist, 50), latency_percentile(hist, 99), hist->max);
+}
+
+/**
+ * Press-to-report latency
+ * Every trace replayed through the core and this board's keymap at its recorded pace;
+ * latency.c measures each press from its scan to the report it ends up in, the same code
+ * the firmware runs with LATENCY_ENABLE. The per class p50/p99 are printed per trace and
+ * over all of them, for tuning TAPPING_TERM, HRM_TAPPING_TERM and FLOW_TAP_TERM.
+ */
+TEST_F(Latency, ReplayTraces) {
+    TestDriver driver;
+    load_board_keymap();
+
+    auto traces = load_traces();
+    ASSERT_FALSE(traces.empty()) << "no traces in " LUKE_TRACES;
+
+    latency_hist_t total[LAT_CLASS_COUNT] = {};
+    printf("%s: tapping term %u, hrm term %u, flow tap term %u\n", LUKE_BOARD, TAPPING_TERM, HRM_TAPPING_TERM, FLOW_TAP_TERM);
+
+    for (auto &trace : traces) {
+        if (!fits(trace)) {
+            printf("%-28s skipped, keys this board does not have\n", trace.name.c_str());
+            continue;
+        }
+
+        latency_reset();
+        replay(driver, trace);
+        if (!trace.text.empty()) {
+            EXPECT_EQ(typed, trace.text) << trace.name << ": the host saw different text";
+        }
+
+        size_t samples = 0;
+        for (uint8_t i = 0; i < LAT_CLASS_COUNT; i++) {
+            latency_hist_t sum = *latency_hist(PROFILE_TYPING, i);
+            const latency_hist_t *game = latency_hist(PROFILE_GAME, i);
+            for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+                sum.buckets[b] += game->buckets[b];
+                total[i].buckets[b] += sum.buckets[b];
+            }
+            sum.count += game->count;
+            sum.max = std::max(sum.max, game->max);
+            total[i].count += sum.count;
+            total[i].max = std::max(total[i].max, sum.max);
+            samples += sum.count;
+            print_hist(trace.name.c_str(), latency_class_names[i], &sum);
+        }
+        EXPECT_EQ(samples, trace.presses()) << trace.name << ": presses that never reached the host";
+    }
+
+    for (uint8_t i = 0; i < LAT_CLASS_COUNT; i++) {
+        print_hist("all traces", latency_class_names[i], &total[i]);
+    }
+}
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "replay.hpp"
+
+extern "C" {
+#include "game_mode.h"
+#include "speculative_tap.h"
+#include "tap_hold.h"
+
+static bool speculate = false;
+
+// what luke.c does in these for the modules compiled in, with speculation switchable
+layer_state_t layer_state_set_user(layer_state_t state) {
+    return game_mode_layer_state(state);
+}
+
+bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    if (speculate) {
+        speculative_tap_event(keycode, record);
+    }
+    return true;
+}
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    return !speculate || speculative_tap_process(keycode, record);
+}
+}
+
+class SpeculativeTap : public ReplayFixture {
+   protected:
+    void TearDown() override {
+        speculate = false;
+        ReplayFixture::TearDown();
+    }
+
+    uint8_t key_number(uint16_t keycode) {
+        for (auto &[number, key] : positions) {
+            if (key.code == keycode) {
+                return number;
+            }
+        }
+        ADD_FAILURE() << "no key " << keycode << " on DFLT";
+        return 0;
+    }
+};
+
+/**
+ * Same text
+ * Every trace replayed through the core without speculation, then twice with it, the
+ * second time with the letter shares learned on the first: the host has to see exactly
+ * the same text each time, rollbacks and all
+ */
+TEST_F(SpeculativeTap, TracesTypeTheSameTextWithSpeculation) {
+    TestDriver driver;
+    load_board_keymap();
+
+    auto traces = load_traces();
+    ASSERT_FALSE(traces.empty()) << "no traces in " LUKE_TRACES;
+
+    for (auto &trace : traces) {
+        if (!fits(trace)) {
+            printf("%-28s skipped, keys this board does not have\n", trace.name.c_str());
+            continue;
+        }
+
+        speculate = false;
+        replay(driver, trace);
+        std::string plain = typed;
+        if (!trace.text.empty()) {
+            EXPECT_EQ(plain, trace.text) << trace.name << ": the host saw different text without speculation";
+        }
+
+        speculate = true;
+        for (int pass = 1; pass <= 2; pass++) {
+            speculative_tap_stats_t before = *speculative_tap_stats();
+            replay(driver, trace);
+            EXPECT_EQ(typed, plain) << trace.name << " pass " << pass << ": speculation changed the text";
+
+            const speculative_tap_stats_t *after = speculative_tap_stats();
+            printf("%-28s pass %d: %5lu sent, %5lu hits, %4lu rolled back\n", trace.name.c_str(), pass, (unsigned long)(after->speculations - before.speculations), (unsigned long)(after->hits - before.hits), (unsigned long)(after->rollbacks - before.rollbacks));
+        }
+    }
+
+    const speculative_tap_stats_t *stats = speculative_tap_stats();
+    EXPECT_GT(stats->speculations, 0u) << "no letter ever went out early, the suite proves nothing";
+    EXPECT_EQ(stats->speculations, stats->hits + stats->rollbacks);
+}
+
+/**
+ * Quick tap
+ * The core times a repeat from the key's last release against its quick tap term. Here
+ * the presses are more than TAPPING_TERM apart but the second comes within the quick tap
+ * term of the first release, so the core registers the letter and keeps it held; a
+ * speculative letter would have had that press swallowed and the repeat lost.
+ */
+TEST_F(SpeculativeTap, QuickTapRepeatStaysHeld) {
+    TestDriver driver;
+    load_board_keymap();
+    speculate = true;
+
+    uint8_t     a     = key_number(HRM_A);
+    Trace       trace{"quick tap", "", {}};
+    uint32_t    t     = 0;
+    keyrecord_t probe = {};
+    probe.event.key   = positions.at(a).position;
+    uint16_t quick    = get_quick_tap_term(HRM_A, &probe);
+    ASSERT_GT(quick, 0) << "no quick tap on home row mods";
+
+    // enough clean taps, each past the flow tap and quick tap terms of the last, for the
+    // key's letter share to be trusted
+    for (int i = 0; i < SPECULATIVE_TAP_MIN_SAMPLES + 4; i++) {
+        trace.events.push_back({t, a, true});
+        trace.events.push_back({t + 50, a, false});
+        t += std::max<uint32_t>(FLOW_TAP_TERM, quick) + 100;
+    }
+    // a tap, then a press that comes more than TAPPING_TERM after the first press but
+    // inside the quick tap term of its release, held past the hold term
+    uint32_t up = t + TAPPING_TERM;
+    trace.events.push_back({t, a, true});
+    trace.events.push_back({up, a, false});
+    trace.events.push_back({up + quick / 2, a, true});
+    ASSERT_GT(up + quick / 2 - t, (uint32_t)TAPPING_TERM);
+
+    uint32_t sent = speculative_tap_stats()->speculations;
+    replay(driver, trace, HRM_TAPPING_TERM + 200);
+    EXPECT_GT(speculative_tap_stats()->speculations, sent) << "the warm-up never made the key speculate";
+    EXPECT_TRUE(std::find(std::begin(last.keys), std::end(last.keys), KC_A) != std::end(last.keys)) << "the repeat is not held, typed " << typed;
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(testing::AnyNumber());
+    positions.at(a).release();
+    run_one_scan_loop();
+    idle_for(HRM_TAPPING_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+}
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <stdint.h>
+#include "timer.h"
+
+#if defined(MCU_RP)
+#    include "hal.h"
+#endif
+
+/**
+ * Microsecond timestamps
+ * The RP2040 has a free running 1 MHz timer that ChibiOS also uses for its system tick,
+ * so reading it is free. Other platforms fall back to the millisecond timer.
+ */
+static inline uint32_t timer_read_us(void) {
+#if defined(MCU_RP)
+    return TIMER->TIMERAWL;
+#else
+    return timer_read32() * 1000;
+#endif
+}
+
+static inline uint32_t timer_elapsed_us(uint32_t last) {
+    return timer_read_us() - last;
+}
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Read the typing analytics over raw HID (ANALYTICS_ENABLE = yes) and print heatmaps.
+
+Each run appends one snapshot to a JSON lines file, so layout changes can be compared
+over time. Needs the `hid` package (hidapi bindings), e.g. `pip install hid`.
+
+  users/luke/tools/analytics_collector.py                 read, store, print
+  users/luke/tools/analytics_collector.py --reset         same, then clear the counters
+  users/luke/tools/analytics_collector.py --from FILE     print the last stored snapshot
+"""
+import argparse
+import json
+import struct
+import sys
+import time
+
+RAW_USAGE_PAGE = 0xFF60
+RAW_USAGE = 0x61
+RAW_EPSIZE = 32
+
+RAW_ANALYTICS_READ = 0x01
+RAW_ANALYTICS_RESET = 0x02
+
+VERSION = 1
+COUNTERS = ('typing_ms', 'keys_typed', 'bigrams', 'same_finger', 'same_hand', 'dropped', 'record_calls', 'record_cycles', 'record_cycles_max')
+LAYERS = ('DFLT', 'GAME', 'NAV', 'SYS', 'NUM')
+SHADES = ' .:-=+*#%@'
+
+
+def open_device():
+    import hid
+
+    for info in hid.enumerate():
+        if info['usage_page'] == RAW_USAGE_PAGE and info['usage'] == RAW_USAGE:
+            device = hid.device()
+            device.open_path(info['path'])
+            return device
+    sys.exit('no raw hid interface found, is RAW_ENABLE on?')
+
+
+def transfer(device, payload):
+    report = bytes(payload) + bytes(RAW_EPSIZE - len(payload))
+    device.write(b'\x00' + report)
+    reply = bytes(device.read(RAW_EPSIZE, 1000))
+    if len(reply) < 5 or reply[0] != payload[0]:
+        sys.exit('unexpected reply, is ANALYTICS_ENABLE on?')
+    return reply
+
+
+def read_blob(device):
+    blob = b''
+    size = None
+    while size is None or len(blob) < size:
+        offset = len(blob)
+        reply = transfer(device, [RAW_ANALYTICS_READ, offset & 0xFF, offset >> 8])
+        size = reply[2] | reply[3] << 8
+        count = reply[4]
+        if not count:
+            break
+        blob += reply[5:5 + count]
+    return blob
+
+
+def decode(blob):
+    version, rows, cols, layers = struct.unpack_from('<4B', blob)
+    if version != VERSION:
+        sys.exit(f'analytics version {version}, this collector reads {VERSION}')
+    offset = 4
+    counters = dict(zip(COUNTERS, struct.unpack_from(f'<{len(COUNTERS)}I', blob, offset)))
+    offset += 4 * len(COUNTERS)
+    dwell = list(struct.unpack_from(f'<{layers}I', blob, offset))
+    offset += 4 * layers
+    presses = list(struct.unpack_from(f'<{rows * cols}H', blob, offset))
+    return {
+        'time': int(time.time()),
+        'rows': rows,
+        'cols': cols,
+        **counters,
+        'dwell_ms': dwell,
+        'presses': [presses[r * cols:(r + 1) * cols] for r in range(rows)],
+    }
+
+
+def heatmap(snapshot):
+    presses = snapshot['presses']
+    peak = max(max(row) for row in presses) or 1
+    # split boards scan each half as its own block of rows, print them side by side
+    half = len(presses) // 2
+    print('presses by matrix position (left half | right half)')
+    for left, right in zip(presses[:half], presses[half:]):
+        cells = [SHADES[min(len(SHADES) - 1, count * len(SHADES) // (peak + 1))] * 2 + f'{count:>6}' for count in left + right]
+        print(' '.join(cells[:len(left)]) + '  |  ' + ' '.join(cells[len(left):]))
+
+
+def summary(snapshot):
+    minutes = snapshot['typing_ms'] / 60000
+    wpm = snapshot['keys_typed'] / 5 / minutes if minutes else 0
+    bigrams = snapshot['bigrams'] or 1
+    print(f'\nwpm {wpm:.0f} over {minutes:.1f} min of typing, {snapshot["keys_typed"]} keys on DFLT')
+    print(f'same finger {100 * snapshot["same_finger"] / bigrams:.2f}%  same hand {100 * snapshot["same_hand"] / bigrams:.1f}%  of {snapshot["bigrams"]} bigrams')
+
+    total = sum(snapshot['dwell_ms']) or 1
+    print('layer dwell ' + '  '.join(f'{name} {100 * ms / total:.1f}%' for name, ms in zip(LAYERS, snapshot['dwell_ms'])))
+
+    calls = snapshot['record_calls'] or 1
+    print(f'record path {snapshot["record_cycles"] / calls:.0f} cycles avg, {snapshot["record_cycles_max"]} max, {snapshot["dropped"]} events dropped')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--out', default='analytics.jsonl', help='snapshot file to append to (default: %(default)s)')
+    parser.add_argument('--from', dest='source', help='print the last snapshot from this file instead of reading the keyboard')
+    parser.add_argument('--reset', action='store_true', help='clear the counters on the keyboard after reading them')
+    args = parser.parse_args()
+
+    if args.source:
+        with open(args.source) as f:
+            snapshot = json.loads(f.readlines()[-1])
+    else:
+        device = open_device()
+        snapshot = decode(read_blob(device))
+        with open(args.out, 'a') as f:
+            f.write(json.dumps(snapshot) + '\n')
+        if args.reset:
+            transfer(device, [RAW_ANALYTICS_RESET])
+        device.close()
+
+    heatmap(snapshot)
+    summary(snapshot)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,273 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Footprint and hot callback benchmark for every qmk.json build target (`make bench`).
+
+Builds each target, reads flash/RAM and the size of every symbol that comes from our
+keymap.c or users/luke out of the ELF, and optionally folds in the on-target cycle
+histograms of the hot callbacks from a PROFILE_ENABLE console capture, and the keycode
+lookup cost from flash, EEPROM and the RAM keymap when the capture has a REMAP_ENABLE
+STAT_RPT dump. The hot callbacks are also timed natively, built against the shims in
+tests/host, which needs neither qmk_firmware nor a board:
+
+  make bench                                   build, measure, compare to the baseline
+  make bench BENCH_ARGS="--profile con.log"    also compare profiled callback cycles
+  make bench BENCH_ARGS=--update-baseline      accept the current numbers as the baseline
+  users/luke/tools/bench.py --native-only      only the native timings, no qmk_firmware
+
+Results are written as JSON (--out) and compared against users/luke/bench_baseline.json;
+anything over the thresholds stored in the baseline fails the run. --update-baseline
+only replaces what was measured, so a --native-only run keeps the target footprints.
+Native timings are host nanoseconds and only compared on the machine that recorded them.
+Anything measured that the baseline cannot be compared with, a target or callback it has
+no numbers for or native timings from another machine, is listed as skipped and the run
+exits 2 rather than passing; --allow-skips accepts that, --no-native leaves the native
+timings out altogether.
+"""
+import argparse
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+
+from profile_reader import percentile
+
+USERSPACE = os.path.realpath(os.path.join(os.path.dirname(__file__), '..', '..', '..'))
+BASELINE = os.path.join(USERSPACE, 'users', 'luke', 'bench_baseline.json')
+OURS = re.compile(r'/(users/luke|keymaps/luke)/')
+LOOKUP = re.compile(r'remap lookup cycles: progmem (\d+) eeprom (\d+) ram (\d+)')
+HOST = os.path.join(USERSPACE, 'users', 'luke', 'tests', 'host')
+NATIVE = re.compile(r'^bench (\w+) ([\d.]+)$', re.M)
+
+# cycles are compared at percentile bucket edges, so anything flagged at least doubled
+HOT_CALLBACKS = ('get_tapping_term', 'get_quick_tap_term', 'get_flow_tap_term', 'layer_state_set_user', 'post_process_record_user')
+
+THRESHOLDS = {
+    'flash_bytes': 256,   # per target, and for our own symbols
+    'ram_bytes': 64,
+    'symbol_bytes': 64,   # any single symbol of ours
+    'cycles_percent': 50, # p50/p99 of a hot callback
+    'native_percent': 100, # ns per call of a hot callback on the host, noisier than cycles
+}
+
+
+def run(args, **kwargs):
+    return subprocess.run(args, check=True, capture_output=True, text=True, **kwargs).stdout
+
+
+def build(keyboard, keymap, qmk_home):
+    print(f'building {keyboard}:{keymap}', file=sys.stderr)
+    subprocess.run(['qmk', 'compile', '-kb', keyboard, '-km', keymap], cwd=USERSPACE, check=True, stdout=subprocess.DEVNULL)
+    return os.path.join(qmk_home, '.build', f'{keyboard.replace("/", "_")}_{keymap}.elf')
+
+
+def footprint(elf, prefix):
+    # berkeley format: text data bss dec hex filename
+    text, data, bss = (int(v) for v in run([f'{prefix}size', '-B', elf]).splitlines()[1].split()[:3])
+
+    symbols = {}
+    flash = ram = 0
+    for line in run([f'{prefix}nm', '-S', '-l', '--size-sort', elf]).splitlines():
+        fields = line.split(maxsplit=4)
+        if len(fields) < 5 or not OURS.search(fields[4]):
+            continue
+        size, kind, name = int(fields[1], 16), fields[2].lower(), fields[3]
+        symbols[name] = {'size': size, 'type': kind}
+        if kind in 'trd':
+            flash += size
+        if kind in 'db':
+            ram += size
+
+    return {
+        'flash': text + data,
+        'ram': data + bss,
+        'ours_flash': flash,
+        'ours_ram': ram,
+        'symbols': symbols,
+    }
+
+
+def cycles(log):
+    hooks = {}
+    with open(log) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) < 4 or fields[0] != 'prof' or fields[1] not in HOT_CALLBACKS:
+                continue
+            buckets = [int(b) for b in fields[4:]]
+            # later dumps in the same capture supersede earlier ones
+            hooks[fields[1]] = {'calls': int(fields[2]), 'max': int(fields[3]), 'p50': percentile(buckets, 50), 'p99': percentile(buckets, 99)}
+    return hooks
+
+
+def lookup(log):
+    costs = {}
+    with open(log) as f:
+        for line in f:
+            match = LOOKUP.search(line)
+            if match:
+                costs = dict(zip(('progmem', 'eeprom', 'ram'), (int(v) for v in match.groups())))
+    return costs
+
+
+def machine():
+    """What the native timings were taken on, they only compare on the same"""
+    model = platform.processor()
+    if os.path.exists('/proc/cpuinfo'):
+        with open('/proc/cpuinfo') as f:
+            model = next((line.split(':', 1)[1].strip() for line in f if line.startswith('model name')), model)
+    return f'{platform.system()} {platform.machine()} {model}'.strip()
+
+
+def native():
+    """ns per call of every hot callback, see tests/host/bench.cpp"""
+    print('timing the hot callbacks natively', file=sys.stderr)
+    timings = {name: float(ns) for name, ns in NATIVE.findall(run(['make', '-C', HOST, 'bench']))}
+    missing = set(HOT_CALLBACKS) - set(timings)
+    if missing:
+        sys.exit(f'tests/host/bench.cpp did not time {", ".join(sorted(missing))}')
+    return {'machine': machine(), 'ns': timings}
+
+
+def compare(results, baseline):
+    """What went over the thresholds, and what had nothing in the baseline to compare to"""
+    limits = baseline.get('thresholds', THRESHOLDS)
+    failures = []
+    skipped = []
+
+    def check(what, now, then, limit):
+        if then is not None and now - then > limit:
+            failures.append(f'{what}: {then} -> {now} (+{round(now - then, 2)}, limit {round(limit, 2)})')
+
+    for target, now in results['targets'].items():
+        then = baseline.get('targets', {}).get(target)
+        if not then:
+            skipped.append(f'{target}: no footprint in the baseline')
+            continue
+        check(f'{target} flash', now['flash'], then['flash'], limits['flash_bytes'])
+        check(f'{target} ram', now['ram'], then['ram'], limits['ram_bytes'])
+        check(f'{target} our flash', now['ours_flash'], then['ours_flash'], limits['flash_bytes'])
+        check(f'{target} our ram', now['ours_ram'], then['ours_ram'], limits['ram_bytes'])
+        for name, symbol in now['symbols'].items():
+            check(f'{target} {name}', symbol['size'], then['symbols'].get(name, {}).get('size', 0), limits['symbol_bytes'])
+
+    for hook, now in results['cycles'].items():
+        then = baseline.get('cycles', {}).get(hook)
+        if not then:
+            skipped.append(f'{hook}: no cycles in the baseline')
+            continue
+        for key in ('p50', 'p99'):
+            check(f'{hook} {key} cycles', now[key], then[key], then[key] * limits['cycles_percent'] // 100)
+
+    then = baseline.get('lookup', {}).get('ram')
+    if results['lookup'] and then:
+        check('ram keycode lookup cycles', results['lookup']['ram'], then, then * limits['cycles_percent'] // 100)
+    elif results['lookup']:
+        skipped.append('keycode lookup: no cycles in the baseline')
+
+    then = baseline.get('native', {})
+    if results['native'] and then.get('machine') != results['native']['machine']:
+        skipped.append(f'native timings: the baseline is from {then.get("machine", "nowhere")}, this is {results["native"]["machine"]}')
+    elif results['native']:
+        percent = limits.get('native_percent', THRESHOLDS['native_percent'])
+        for hook, now in results['native']['ns'].items():
+            if hook in then['ns']:
+                check(f'{hook} native ns', now, then['ns'][hook], then['ns'][hook] * percent / 100)
+            else:
+                skipped.append(f'{hook}: no native timing in the baseline')
+
+    return failures, skipped
+
+
+def report(results):
+    for target, now in results['targets'].items():
+        print(f'\n{target}: flash {now["flash"]} ram {now["ram"]}, ours flash {now["ours_flash"]} ram {now["ours_ram"]}')
+        largest = sorted(now['symbols'].items(), key=lambda s: -s[1]['size'])
+        for name, symbol in largest[:15]:
+            print(f'  {symbol["size"]:>6} {symbol["type"]} {name}')
+    if results['cycles']:
+        print(f'\n{"callback":<26} {"calls":>10} {"p50":>8} {"p99":>8} {"max":>8}  cycles')
+        for hook, now in results['cycles'].items():
+            print(f'{hook:<26} {now["calls"]:>10} {now["p50"]:>8} {now["p99"]:>8} {now["max"]:>8}')
+    if results['lookup']:
+        print('\nkeycode lookup cycles ' + '  '.join(f'{source} {cost}' for source, cost in results['lookup'].items()))
+    if results['native']:
+        print(f'\n{"callback":<26} {"ns/call":>8}  native, {results["native"]["machine"]}')
+        for hook, ns in results['native']['ns'].items():
+            print(f'{hook:<26} {ns:>8.2f}')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--qmk-home', help='qmk_firmware checkout the targets are built in')
+    parser.add_argument('--prefix', default='arm-none-eabi-', help='binutils prefix (default: %(default)s)')
+    parser.add_argument('--profile', help='console capture holding a PROFILE_ENABLE (and REMAP_ENABLE) STAT_RPT dump')
+    parser.add_argument('--no-build', action='store_true', help='measure the ELF files already in .build')
+    parser.add_argument('--out', default=os.path.join(USERSPACE, 'bench_results.json'), help='results file (default: %(default)s)')
+    parser.add_argument('--native-only', action='store_true', help='only time the hot callbacks natively, build no targets')
+    parser.add_argument('--no-native', action='store_true', help='skip the native timings')
+    parser.add_argument('--update-baseline', action='store_true', help='write the results as the new baseline')
+    parser.add_argument('--allow-skips', action='store_true', help='pass when something measured had no baseline to compare to')
+    args = parser.parse_args()
+    if not args.native_only and not args.qmk_home:
+        parser.error('--qmk-home is needed to build the targets, or run with --native-only')
+
+    with open(os.path.join(USERSPACE, 'qmk.json')) as f:
+        targets = json.load(f)['build_targets']
+
+    results = {
+        'targets': {},
+        'cycles': cycles(args.profile) if args.profile else {},
+        'lookup': lookup(args.profile) if args.profile else {},
+        'native': {} if args.no_native else native(),
+    }
+    for keyboard, keymap in [] if args.native_only else targets:
+        elf = os.path.join(args.qmk_home, '.build', f'{keyboard.replace("/", "_")}_{keymap}.elf') if args.no_build else build(keyboard, keymap, args.qmk_home)
+        results['targets'][f'{keyboard}:{keymap}'] = footprint(elf, args.prefix)
+
+    with open(args.out, 'w') as f:
+        json.dump(results, f, indent=2)
+    report(results)
+
+    baseline = {}
+    if os.path.exists(BASELINE):
+        with open(BASELINE) as f:
+            baseline = json.load(f)
+
+    if args.update_baseline:
+        # what was not measured this run stays as it was
+        updated = {
+            'thresholds': {**THRESHOLDS, **baseline.get('thresholds', {})},
+            'targets': {**baseline.get('targets', {}), **results['targets']},
+        }
+        for section in ('cycles', 'lookup', 'native'):
+            updated[section] = results[section] or baseline.get(section, {})
+        with open(BASELINE, 'w') as f:
+            json.dump(updated, f, indent=2)
+            f.write('\n')
+        print(f'\nbaseline written to {os.path.relpath(BASELINE, USERSPACE)}')
+        return
+
+    if not args.profile and baseline.get('cycles'):
+        print('\nno --profile capture, callback cycles not compared')
+
+    failures, skipped = compare(results, baseline)
+    if failures:
+        print('\nover the baseline thresholds:')
+        for failure in failures:
+            print(f'  {failure}')
+        sys.exit(1)
+    if skipped:
+        print(f'\nSKIPPED, nothing in {os.path.relpath(BASELINE, USERSPACE)} to compare with:')
+        for skip in skipped:
+            print(f'  {skip}')
+        print('record them with --update-baseline on a known good tree, on the machine the numbers are for')
+        if not args.allow_skips:
+            sys.exit(2)
+        return
+    print('\nwithin the baseline thresholds')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,332 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Rollover stress and invariant fuzzer for the userspace, on the boards (FUZZ_ENABLE = yes).
+
+The same streams and invariants run natively in the tests/fuzz suite, against both
+keymaps and the core's tap-hold code, with `make fuzz` and `make test`; this is the
+hardware mode, for everything the test framework does not build: the matrix, the split
+link, the scan governor and the timing of a real scan.
+
+Each seed expands to a reproducible press/release stream: rolls at typing speed, bursts
+well past 20 keys/s, and long holds across the tapping terms, drawn mostly from the
+tap-hold, mod and layer keys. The board presses the stream into its matrix at the pace
+it was written, so the core scans it like typing, and checks, once everything has
+settled, that no mods, keys or layers were left behind and that every tap-hold press
+settled exactly once. A failing stream is shrunk to the fewest keystrokes that still
+fail and can be saved and replayed.
+
+Each board compiles its own keymap, so run it on every qmk.json target: `make fuzz-boards`
+from the userspace root flashes each in turn with FUZZ_ENABLE = yes, both halves of a split,
+waits for it to come back and runs the streams on it. The board types nothing while a
+stream runs, but keep hands off it: real presses mix into the stream. No CI runs this,
+it needs the boards. Needs the `hid` package (hidapi bindings) and, for --boards, the
+QMK CLI.
+
+  users/luke/tools/fuzz.py                            100 streams from seed 0
+  users/luke/tools/fuzz.py --seeds 1000 --start 5000  more, elsewhere
+  users/luke/tools/fuzz.py --rate 40 --save fail.json faster, keep the first failure
+  users/luke/tools/fuzz.py --replay fail.json         rerun a saved stream
+  make fuzz-boards FUZZ_ARGS="--seeds 500"            flash and fuzz every target
+
+The streams reach the core through a link time wrap of matrix_get_row. Every stream
+checks that each of its presses came out as a key event, so a build where the wrap does
+not fire, LTO folding the call away for one, stops the run at the first stream.
+"""
+import argparse
+import json
+import os
+import random
+import struct
+import subprocess
+import sys
+import time
+
+USERSPACE = os.path.realpath(os.path.join(os.path.dirname(__file__), '..', '..', '..'))
+
+RAW_USAGE_PAGE = 0xFF60
+RAW_USAGE = 0x61
+RAW_EPSIZE = 32
+
+RAW_FUZZ_INFO = 0x20
+RAW_FUZZ_LOAD = 0x21
+RAW_FUZZ_RUN = 0x22
+RAW_FUZZ_STATUS = 0x23
+
+STATUS = ('ok', 'busy', 'stream too long')
+STATE_DONE = 3
+EVENTS_PER_LOAD = (RAW_EPSIZE - 4) // 4
+
+# keep in step with enum fuzz_failure in fuzz.h
+FAILURES = ('stuck mods', 'stuck keys', 'stuck layer', 'lost tap-hold outcome', 'extra tap-hold outcome', 'bad stream', 'unseen press')
+UNSEEN_PRESS = 1 << FAILURES.index('unseen press')
+
+# stream shape
+MAX_ROLLOVER = 6     # keys down at once
+BURST_CHANCE = 0.15  # a burst starts instead of a normal gap
+BURST_LENGTH = (3, 8)
+BURST_GAP_MS = (0, 15)
+HOLD_CHANCE = 0.1    # a gap long enough to settle the keys down as holds
+HOLD_GAP_MS = (150, 450)
+SPECIAL_SHARE = 0.5  # presses taken from the tap-hold, mod and layer keys
+
+
+def open_device(wait=0):
+    import hid
+
+    deadline = time.monotonic() + wait
+    while True:
+        for info in hid.enumerate():
+            if info['usage_page'] == RAW_USAGE_PAGE and info['usage'] == RAW_USAGE:
+                device = hid.device()
+                device.open_path(info['path'])
+                return device
+        if time.monotonic() >= deadline:
+            sys.exit('no raw hid interface found, is RAW_ENABLE on?')
+        time.sleep(0.5)
+
+
+def transfer(device, payload):
+    report = bytes(payload) + bytes(RAW_EPSIZE - len(payload))
+    device.write(b'\x00' + report)
+    reply = bytes(device.read(RAW_EPSIZE, 1000))
+    if len(reply) < 2 or reply[0] != payload[0]:
+        sys.exit('unexpected reply, is FUZZ_ENABLE on?')
+    if reply[1]:
+        sys.exit(f'keyboard says: {STATUS[reply[1]] if reply[1] < len(STATUS) else reply[1]}')
+    return reply
+
+
+def info(device):
+    reply = transfer(device, [RAW_FUZZ_INFO])
+    rows, cols, max_events = reply[2], reply[3], reply[4]
+    special = []
+    for row in range(rows):
+        mask = reply[5 + 2 * row] | reply[6 + 2 * row] << 8
+        special += [(row, col) for col in range(cols) if mask >> col & 1]
+    return {'rows': rows, 'cols': cols, 'max_events': max_events, 'special': special}
+
+
+def generate(seed, layout, rate, length):
+    """Events as (delay ms, row, col, pressed); every press is released by the end"""
+    rng = random.Random(seed)
+    keys = [(row, col) for row in range(layout['rows']) for col in range(layout['cols'])]
+    special = layout['special'] or keys
+    events, held = [], []
+    burst = 0
+
+    def gap():
+        nonlocal burst
+        if burst:
+            burst -= 1
+            return rng.randint(*BURST_GAP_MS)
+        roll = rng.random()
+        if roll < BURST_CHANCE:
+            burst = rng.randint(*BURST_LENGTH)
+            return rng.randint(*BURST_GAP_MS)
+        if roll < BURST_CHANCE + HOLD_CHANCE:
+            return rng.randint(*HOLD_GAP_MS)
+        return min(int(rng.expovariate(rate / 1000)), 1000)
+
+    # presses stop once only the releases of what is down still fit
+    while len(events) + len(held) + 1 < length:
+        if held and (len(held) >= MAX_ROLLOVER or rng.random() < 0.45):
+            key = held.pop(rng.randrange(len(held)))
+            events.append((gap(), *key, False))
+            continue
+        pool = special if rng.random() < SPECIAL_SHARE else keys
+        key = rng.choice(pool)
+        if key not in held:
+            held.append(key)
+            events.append((gap(), *key, True))
+    rng.shuffle(held)
+    events += [(gap(), *key, False) for key in held]
+    return events
+
+
+def run(device, events):
+    for index in range(0, len(events), EVENTS_PER_LOAD):
+        chunk = events[index:index + EVENTS_PER_LOAD]
+        payload = [RAW_FUZZ_LOAD, 0, index, len(chunk)]
+        for delay, row, col, pressed in chunk:
+            payload += [delay & 0xFF, delay >> 8, row << 4 | col, int(pressed)]
+        transfer(device, payload)
+    transfer(device, [RAW_FUZZ_RUN, 0, len(events)])
+
+    # the stream, then the settle time and a margin for the scheduling around it
+    deadline = time.monotonic() + sum(event[0] for event in events) / 1000 + 5
+    while time.monotonic() < deadline:
+        time.sleep(0.05)
+        reply = transfer(device, [RAW_FUZZ_STATUS])
+        if reply[2] == STATE_DONE:
+            failures, mods = reply[3], reply[4]
+            layers, processed, busy_us, max_us, elapsed_ms = struct.unpack_from('<IHIII', reply, 5)
+            return {'failures': failures, 'mods': mods, 'layers': layers, 'events': processed, 'busy_us': busy_us, 'max_us': max_us, 'elapsed_ms': elapsed_ms}
+    sys.exit('stream did not finish, is the board still there?')
+
+
+def describe(failures):
+    return ', '.join(name for bit, name in enumerate(FAILURES) if failures >> bit & 1) or 'ok'
+
+
+def peak_rate(events, window_ms=250):
+    """Most presses in any window, per second"""
+    times, now = [], 0
+    for delay, _, _, pressed in events:
+        now += delay
+        if pressed:
+            times.append(now)
+    peak, first = 0, 0
+    for last, t in enumerate(times):
+        while t - times[first] >= window_ms:
+            first += 1
+        peak = max(peak, last - first + 1)
+    return peak * 1000 / window_ms
+
+
+def keystrokes(events):
+    """Pairs each press with its release, as the (index, time) of both and the key"""
+    strokes, down, now = [], {}, 0
+    for index, (delay, row, col, pressed) in enumerate(events):
+        now += delay
+        if pressed:
+            down[(row, col)] = (index, now)
+        else:
+            strokes.append((down.pop((row, col)), (index, now), row, col))
+    return sorted(strokes)
+
+
+def stream(strokes):
+    """Back to events, the surviving keystrokes in their original order and at their original times"""
+    timeline = sorted([(*down, row, col, True) for down, _, row, col in strokes] + [(*up, row, col, False) for _, up, row, col in strokes])
+    # the quiet stretch before the first surviving press is dropped too
+    events, now = [], timeline[0][1] if timeline else 0
+    for _, t, row, col, pressed in timeline:
+        events.append((t - now, row, col, pressed))
+        now = t
+    return events
+
+
+def minimize(check, events, failures):
+    """Delta debugging over keystrokes: drops chunks while the same invariant still breaks"""
+    strokes = keystrokes(events)
+    chunks = 2
+    while len(strokes) >= 2:
+        size = max(len(strokes) // chunks, 1)
+        for start in range(0, len(strokes), size):
+            rest = strokes[:start] + strokes[start + size:]
+            if rest and check(stream(rest)) & failures:
+                strokes = rest
+                chunks = max(chunks - 1, 2)
+                break
+        else:
+            if size == 1:
+                break
+            chunks = min(chunks * 2, len(strokes))
+    return stream(strokes)
+
+
+def print_stream(events):
+    now = 0
+    for delay, row, col, pressed in events:
+        now += delay
+        print(f'  {now:>6} ms  {"down" if pressed else "up  "}  row {row:>2} col {col:>2}')
+
+
+def fuzz(device, layout, args):
+    """The seeds on one board, failures shrunk and reported as they come; the failed count"""
+    length = min(args.length or layout['max_events'], layout['max_events'])
+    totals = {'streams': 0, 'failed': 0, 'events': 0, 'busy_us': 0, 'max_us': 0, 'elapsed_ms': 0}
+    peak = 0
+    saved = False
+    for seed in range(args.start, args.start + args.seeds):
+        events = generate(seed, layout, args.rate, length)
+        result = run(device, events)
+        peak = max(peak, peak_rate(events))
+        totals['streams'] += 1
+        totals['events'] += result['events']
+        totals['busy_us'] += result['busy_us']
+        totals['elapsed_ms'] += result['elapsed_ms']
+        totals['max_us'] = max(totals['max_us'], result['max_us'])
+        if not result['failures']:
+            continue
+
+        totals['failed'] += 1
+        print(f'seed {seed}: {describe(result["failures"])}, mods 0x{result["mods"]:02X}, layers 0x{result["layers"]:X}')
+        if result['failures'] & UNSEEN_PRESS:
+            sys.exit('the core never saw the stream\'s presses: the matrix_get_row wrap did not fire in this build')
+        if not args.no_minimize:
+            events = minimize(lambda candidate: run(device, candidate)['failures'], events, result['failures'])
+            print(f'  shrunk to {len(events) // 2} keystrokes:')
+            print_stream(events)
+        if args.save and not saved:
+            with open(args.save, 'w') as f:
+                json.dump({'seed': seed, 'failures': result['failures'], 'events': events}, f)
+            saved = True
+
+    busy = max(totals['busy_us'], 1)
+    print(f'{totals["streams"]} streams, {totals["failed"]} failed, {totals["events"]} events')
+    print(f'stream rate {totals["events"] * 1000 / max(totals["elapsed_ms"], 1):.1f} events/s, peak {peak:.0f} presses/s over 250 ms')
+    # per scan that carried stream events, to the end of its keyboard task
+    print(f'processing {totals["busy_us"] / max(totals["events"], 1):.0f} us/event avg, {totals["max_us"]} us/scan max, {totals["events"] * 1e6 / busy:.0f} events/s capacity')
+    return totals['failed']
+
+
+def flash(keyboard, keymap):
+    """FUZZ_ENABLE firmware on the board, each half of a split, then the board back on raw hid"""
+    info = json.loads(subprocess.run(['qmk', 'info', '-kb', keyboard, '-f', 'json'], cwd=USERSPACE, check=True, capture_output=True, text=True).stdout)
+    halves = ('left half', 'right half') if info.get('split', {}).get('enabled') else ('board',)
+    for half in halves:
+        print(f'{keyboard}:{keymap}: plug in the {half} and put it in its bootloader', flush=True)
+        subprocess.run(['qmk', 'flash', '-kb', keyboard, '-km', keymap, '-e', 'FUZZ_ENABLE=yes'], cwd=USERSPACE, check=True, stdout=subprocess.DEVNULL)
+    print(f'{keyboard}:{keymap}: plug the board back in the way you use it', flush=True)
+    return open_device(wait=120)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--seeds', type=int, default=100, help='streams to run')
+    parser.add_argument('--start', type=int, default=0, help='first seed')
+    parser.add_argument('--rate', type=float, default=25, help='keys per second outside bursts')
+    parser.add_argument('--length', type=int, help='events per stream, the board maximum by default')
+    parser.add_argument('--save', help='write the first failing stream, shrunk, to this file')
+    parser.add_argument('--replay', help='rerun a stream saved with --save')
+    parser.add_argument('--no-minimize', action='store_true', help='report failures as generated')
+    parser.add_argument('--boards', action='store_true', help='flash and fuzz every qmk.json target in turn')
+    args = parser.parse_args()
+
+    if args.boards:
+        if args.replay:
+            parser.error('--replay runs on the board that is plugged in, not with --boards')
+        with open(os.path.join(USERSPACE, 'qmk.json')) as f:
+            targets = json.load(f)['build_targets']
+        failed = []
+        for keyboard, keymap in targets:
+            device = flash(keyboard, keymap)
+            if fuzz(device, info(device), args):
+                failed.append(f'{keyboard}:{keymap}')
+            device.close()
+        if failed:
+            sys.exit('failed: ' + ', '.join(failed))
+        print('no stream failed on any target')
+        return
+
+    device = open_device()
+    layout = info(device)
+
+    if args.replay:
+        with open(args.replay) as f:
+            saved = json.load(f)
+        events = [tuple(event) for event in saved['events']]
+        result = run(device, events)
+        print(f'seed {saved["seed"]}: {len(events)} events, {describe(result["failures"])} (saved: {describe(saved["failures"])})')
+        print_stream(events)
+        device.close()
+        return
+
+    failed = fuzz(device, layout, args)
+    device.close()
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Speed curve generator and host simulation for the NAV layer pointer (pointer.c).
+
+The simulation steps the same integer fixed-point engine the firmware runs, so the
+trajectories and per-report steps it prints are the ones the host will see:
+
+  users/luke/tools/pointer_sim.py                     simulate the stock gestures
+  users/luke/tools/pointer_sim.py --plot out.png      also plot them (needs matplotlib)
+  users/luke/tools/pointer_sim.py --header            regenerate users/luke/pointer_curve.h
+
+Cycles per report on the board come from the pointer_task profiler hook
+(PROFILE_ENABLE, tools/profile_reader.py or make bench); the simulation reports the
+work per report that drives them, engine steps and table reads.
+"""
+import argparse
+import os
+
+# keep in step with pointer.h
+REPORT_MS = 2
+ACCEL_SHIFT = 3
+FRICTION_SHIFT = 4
+DIAGONAL = 181  # 256 / sqrt(2)
+
+# speed curve: Q8 pixels per millisecond against time held, eased in quadratically
+CURVE_STEP_SHIFT = 4  # 16 ms per entry
+CURVE_LEN = 64        # full speed after about a second
+SPEED_MIN = 0.08      # px/ms, fine positioning on a tap
+SPEED_MAX = 1.6       # px/ms, across a 4k screen in about 2.5 s
+
+HEADER = os.path.join(os.path.dirname(__file__), '..', 'pointer_curve.h')
+
+
+def curve():
+    return [round(256 * (SPEED_MIN + (SPEED_MAX - SPEED_MIN) * (i / (CURVE_LEN - 1)) ** 2)) for i in range(CURVE_LEN)]
+
+
+def write_header(table):
+    rows = [', '.join(f'{v:>3}' for v in table[i:i + 16]) for i in range(0, len(table), 16)]
+    with open(HEADER, 'w') as f:
+        f.write('// SPDX-License-Identifier: GPL-2.0-or-later\n')
+        f.write('// generated by tools/pointer_sim.py --header, edit the curve there\n')
+        f.write('#pragma once\n\n')
+        f.write(f'#define POINTER_CURVE_STEP_SHIFT {CURVE_STEP_SHIFT}\n')
+        f.write(f'#define POINTER_CURVE_LEN        {CURVE_LEN}\n\n')
+        f.write('// Q8 pixels per millisecond, indexed by time held >> POINTER_CURVE_STEP_SHIFT\n')
+        f.write('static const uint16_t PROGMEM pointer_curve[POINTER_CURVE_LEN] = {\n')
+        f.write(''.join(f'    {row},\n' for row in rows))
+        f.write('};\n')
+
+
+class Engine:
+    """pointer.c, one call of step() per millisecond and report() per report"""
+
+    def __init__(self, table):
+        self.table = table
+        self.vx = self.vy = 0
+        self.ax = self.ay = 0
+        self.held_ms = 0
+        self.reads = 0
+
+    def step(self, dx, dy):
+        if dx or dy:
+            speed = self.table[min(self.held_ms >> CURVE_STEP_SHIFT, CURVE_LEN - 1)]
+            self.reads += 1
+            if dx and dy:
+                speed = speed * DIAGONAL >> 8
+            self.held_ms += 1
+        else:
+            speed = 0
+            self.held_ms = 0
+        for axis, direction in (('x', dx), ('y', dy)):
+            v = getattr(self, 'v' + axis)
+            target = direction * speed
+            shift = ACCEL_SHIFT if direction else FRICTION_SHIFT
+            delta = target - v
+            # the shift alone never closes the last few units, step them directly
+            v += (delta >> shift) or (delta > 0) - (delta < 0)
+            setattr(self, 'v' + axis, v)
+            setattr(self, 'a' + axis, getattr(self, 'a' + axis) + v)
+
+    def report(self):
+        mx, my = self.ax >> 8, self.ay >> 8
+        self.ax -= mx << 8
+        self.ay -= my << 8
+        return max(-127, min(127, mx)), max(-127, min(127, my))
+
+
+GESTURES = {
+    'tap right 40 ms': [(40, 1, 0), (200, 0, 0)],
+    'hold right 1.5 s': [(1500, 1, 0), (200, 0, 0)],
+    'diagonal 800 ms': [(800, 1, 1), (200, 0, 0)],
+    'right then up': [(600, 1, 0), (600, 0, -1), (200, 0, 0)],
+}
+
+
+def simulate(table, phases):
+    engine = Engine(table)
+    x = y = 0
+    path, steps = [(0, 0, 0)], []
+    t = 0
+    for duration, dx, dy in phases:
+        for _ in range(duration):
+            engine.step(dx, dy)
+            t += 1
+            if t % REPORT_MS == 0:
+                mx, my = engine.report()
+                if mx or my:
+                    steps.append(max(abs(mx), abs(my)))
+                x, y = x + mx, y + my
+                path.append((t, x, y))
+    return path, steps, engine.reads
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--header', action='store_true', help='write pointer_curve.h from the curve parameters')
+    parser.add_argument('--plot', help='save the trajectories to this image')
+    args = parser.parse_args()
+
+    table = curve()
+    if args.header:
+        write_header(table)
+        print(f'wrote {os.path.relpath(HEADER)}')
+        return
+
+    results = {}
+    print(f'{"gesture":<18} {"end x,y":>12} {"reports":>8} {"max step":>9} {"steps/report":>13} {"table reads":>12}')
+    for name, phases in GESTURES.items():
+        path, steps, reads = simulate(table, phases)
+        results[name] = path
+        end = f'{path[-1][1]},{path[-1][2]}'
+        print(f'{name:<18} {end:>12} {len(steps):>8} {max(steps, default=0):>9} {REPORT_MS:>13} {reads:>12}')
+
+    if args.plot:
+        import matplotlib.pyplot as plt
+
+        fig, (space, time) = plt.subplots(1, 2, figsize=(12, 5))
+        for name, path in results.items():
+            space.plot([p[1] for p in path], [-p[2] for p in path], label=name)
+            time.plot([p[0] for p in path], [abs(p[1]) + abs(p[2]) for p in path], label=name)
+        space.set_title('cursor path (px)')
+        time.set_title('distance travelled against time (ms)')
+        space.legend()
+        fig.savefig(args.plot)
+        print(f'plotted to {args.plot}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Summarize the scan-loop profiler dump (PROFILE_ENABLE = yes, STAT_RPT key).
+
+Pipe the console into it, e.g. `qmk console | users/luke/tools/profile_reader.py`.
+Bucket n counts calls that took 2^(n-1) to 2^n - 1 cycles, so percentiles are
+reported as the upper edge of their bucket.
+"""
+import argparse
+import sys
+
+
+def percentile(buckets, percent):
+    total = sum(buckets)
+    if not total:
+        return 0
+    target = (total * percent + 99) // 100
+    seen = 0
+    for n, count in enumerate(buckets):
+        seen += count
+        if seen >= target:
+            return (1 << n) - 1
+    return (1 << len(buckets)) - 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--mhz', type=float, default=125.0, help='core clock, for the microsecond columns (default: %(default)s, RP2040)')
+    args = parser.parse_args()
+
+    for line in sys.stdin:
+        fields = line.split()
+        if len(fields) < 2 or fields[0] != 'prof':
+            continue
+        if fields[1] == 'scans_per_sec':
+            print(f'\nscans/sec {fields[2]}')
+            print(f'{"hook":<26} {"calls":>10} {"p50":>8} {"p99":>8} {"max":>8}  cycles (us)')
+            continue
+
+        hook, calls, peak = fields[1], int(fields[2]), int(fields[3])
+        buckets = [int(b) for b in fields[4:]]
+        p50, p99 = percentile(buckets, 50), percentile(buckets, 99)
+        us = lambda c: c / args.mhz
+        print(f'{hook:<26} {calls:>10} {p50:>8} {p99:>8} {peak:>8}  ({us(p50):.1f} / {us(p99):.1f} / {us(peak):.1f})')
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Run the QMK test framework suites in users/luke/tests against every qmk.json target (`make test`).
+
+The test framework only builds suites that live in qmk_firmware/tests, on a generic
+matrix. Each suite is staged there once per board as tests/luke_<suite>_<board>, with the
+board's matrix size and LAYOUT() generated from `qmk info` so its keymap.c compiles as it
+is, then built and run with `make test:<name>`; the staged folders are removed afterwards.
+
+  make test                                  every suite on every target
+  make test TEST_ARGS="--suite latency"      one suite
+  make fuzz                                  the fuzz suite, with more streams
+  make test TEST_ARGS=--keep                 leave the staged suites for a debugger
+
+Output goes to the terminal and to test_output.txt.
+"""
+import argparse
+import glob
+import json
+import os
+import shutil
+import subprocess
+import sys
+
+USERSPACE = os.path.realpath(os.path.join(os.path.dirname(__file__), '..', '..', '..'))
+LUKE = os.path.join(USERSPACE, 'users', 'luke')
+TESTS = os.path.join(LUKE, 'tests')
+COMMON = os.path.join(TESTS, 'common')
+PREFIX = 'luke_'
+
+
+def suites():
+    return sorted(os.path.basename(os.path.dirname(path)) for path in glob.glob(os.path.join(TESTS, '*', 'test.mk')))
+
+
+def layout_macro(info):
+    """LAYOUT(k0, ...) as a matrix initializer, KC_NO where no key is wired"""
+    rows, cols = info['matrix_size']['rows'], info['matrix_size']['cols']
+    layouts = info['layouts']
+    keys = layouts['LAYOUT' if 'LAYOUT' in layouts else sorted(layouts)[0]]['layout']
+    matrix = [['KC_NO'] * cols for _ in range(rows)]
+    for index, key in enumerate(keys):
+        row, col = key['matrix']
+        matrix[row][col] = f'k{index}'
+    args = ', '.join(f'k{index}' for index in range(len(keys)))
+    body = ', \\\n    '.join('{' + ', '.join(row) + '}' for row in matrix)
+    return f'#define LAYOUT({args}) {{ \\\n    {body} \\\n}}\n'
+
+
+def keymap_path(keyboard, keymap):
+    """The keymap folder QMK would pick, from the keyboard folder up to its first parent with one"""
+    folder = keyboard
+    while folder:
+        path = os.path.join(USERSPACE, 'keyboards', folder, 'keymaps', keymap)
+        if os.path.isdir(path):
+            return path
+        folder = os.path.dirname(folder)
+    sys.exit(f'no {keymap} keymap for {keyboard} in {USERSPACE}')
+
+
+def stage(qmk_home, suite, keyboard, keymap):
+    name = f'{PREFIX}{suite}_{keyboard.replace("/", "_")}'
+    path = os.path.join(qmk_home, 'tests', name)
+    shutil.rmtree(path, ignore_errors=True)
+    os.makedirs(path)
+
+    info = json.loads(subprocess.run(['qmk', 'info', '-kb', keyboard, '-f', 'json'], check=True, capture_output=True, text=True).stdout)
+    keymap_dir = keymap_path(keyboard, keymap)
+
+    for source in glob.glob(os.path.join(COMMON, '*')) + glob.glob(os.path.join(TESTS, suite, '*')):
+        if os.path.basename(source) != 'test.mk':
+            shutil.copy(source, path)
+
+    generated = f'generated by users/luke/tools/qmk_tests.py from `qmk info -kb {keyboard}`, do not edit'
+    with open(os.path.join(path, 'board.h'), 'w') as f:
+        f.write(f'// {generated}\n#pragma once\n\n#include "quantum.h"\n\n{layout_macro(info)}')
+    with open(os.path.join(path, 'board_config.h'), 'w') as f:
+        f.write(f'// {generated}\n#pragma once\n\n')
+        f.write('#undef MATRIX_ROWS\n#undef MATRIX_COLS\n')
+        f.write(f'#define MATRIX_ROWS {info["matrix_size"]["rows"]}\n#define MATRIX_COLS {info["matrix_size"]["cols"]}\n\n')
+        for define, value in (
+            ('QMK_KEYBOARD_H', os.path.join(path, 'board.h')),
+            ('LUKE_BOARD', keyboard),
+            ('LUKE_KEYMAP_C', os.path.join(keymap_dir, 'keymap.c')),
+            ('LUKE_KEYMAP_CONFIG', os.path.join(keymap_dir, 'config.h')),
+            ('LUKE_USER_CONFIG', os.path.join(LUKE, 'config.h')),
+            ('LUKE_TRACES', os.path.join(TESTS, 'traces')),
+        ):
+            f.write(f'#define {define} "{value}"\n')
+    with open(os.path.join(path, 'test.mk'), 'w') as f, open(os.path.join(TESTS, suite, 'test.mk')) as mk:
+        f.write(f'# {generated}\nLUKE_USER := {LUKE}\nLUKE_TEST := {path}\n\n{mk.read()}')
+    return name, path
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--qmk-home', required=True, help='qmk_firmware checkout the suites are built in')
+    parser.add_argument('--suite', action='append', choices=suites(), help='suite to run, repeatable (default: all)')
+    parser.add_argument('--keep', action='store_true', help='leave the staged suites in qmk_firmware/tests')
+    args = parser.parse_args()
+
+    with open(os.path.join(USERSPACE, 'qmk.json')) as f:
+        targets = json.load(f)['build_targets']
+
+    # leftovers of an interrupted run would be picked up by `make test:all`
+    for stale in glob.glob(os.path.join(args.qmk_home, 'tests', f'{PREFIX}*')):
+        shutil.rmtree(stale)
+
+    failed = []
+    with open(os.path.join(USERSPACE, 'test_output.txt'), 'w') as log:
+        for suite in args.suite or suites():
+            for keyboard, keymap in targets:
+                name, path = stage(args.qmk_home, suite, keyboard, keymap)
+                print(f'{name}: {suite} on {keyboard}:{keymap}', flush=True)
+                run = subprocess.run(['make', '-C', args.qmk_home, f'test:{name}'], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+                sys.stdout.write(run.stdout)
+                log.write(run.stdout)
+                if run.returncode:
+                    failed.append(name)
+                if not args.keep:
+                    shutil.rmtree(path)
+
+    if failed:
+        sys.exit('failed: ' + ', '.join(failed))
+    print('all suites passed')
+
+
+if __name__ == '__main__':
+    main()
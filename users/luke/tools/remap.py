@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Remap keys at runtime over raw HID (REMAP_ENABLE = yes), no reflash needed.
+
+Edits take effect on the next key press and are written to EEPROM in one batch a few
+seconds after the first one (REMAP_FLUSH_MS). Positions are matrix positions, as in
+keymaps[]; `dump` prints them. Needs the `hid` package (hidapi bindings).
+
+  users/luke/tools/remap.py info                      layout and remapped key count
+  users/luke/tools/remap.py dump --layer NAV          keycodes by matrix position
+  users/luke/tools/remap.py set DFLT 1 2 KC_Q         remap one key, keycode by name or number
+  users/luke/tools/remap.py reset --layer NAV         back to the compiled-in keymap
+"""
+import argparse
+import sys
+
+RAW_USAGE_PAGE = 0xFF60
+RAW_USAGE = 0x61
+RAW_EPSIZE = 32
+
+RAW_REMAP_INFO = 0x10
+RAW_REMAP_GET = 0x11
+RAW_REMAP_SET = 0x12
+RAW_REMAP_RESET = 0x13
+
+STATUS = ('ok', 'no such position', 'remap table full')
+LAYERS = ('DFLT', 'GAME', 'NAV', 'SYS', 'NUM')
+
+# the basic keycodes worth typing by name; anything else goes in as a number
+NAMES = {
+    **{f'KC_{chr(ord("A") + i)}': 0x04 + i for i in range(26)},
+    **{f'KC_{i}': 0x1E + i - 1 for i in range(1, 10)},
+    'KC_0': 0x27, 'KC_ENT': 0x28, 'KC_ESC': 0x29, 'KC_BSPC': 0x2A, 'KC_TAB': 0x2B, 'KC_SPC': 0x2C,
+    'KC_MINS': 0x2D, 'KC_EQL': 0x2E, 'KC_LBRC': 0x2F, 'KC_RBRC': 0x30, 'KC_BSLS': 0x31, 'KC_SCLN': 0x33,
+    'KC_QUOT': 0x34, 'KC_GRV': 0x35, 'KC_COMM': 0x36, 'KC_DOT': 0x37, 'KC_SLSH': 0x38,
+    'KC_RGHT': 0x4F, 'KC_LEFT': 0x50, 'KC_DOWN': 0x51, 'KC_UP': 0x52,
+    'KC_NO': 0x00, 'KC_TRNS': 0x01,
+}
+CODES = {code: name for name, code in NAMES.items()}
+
+
+def open_device():
+    import hid
+
+    for info in hid.enumerate():
+        if info['usage_page'] == RAW_USAGE_PAGE and info['usage'] == RAW_USAGE:
+            device = hid.device()
+            device.open_path(info['path'])
+            return device
+    sys.exit('no raw hid interface found, is RAW_ENABLE on?')
+
+
+def transfer(device, payload):
+    report = bytes(payload) + bytes(RAW_EPSIZE - len(payload))
+    device.write(b'\x00' + report)
+    reply = bytes(device.read(RAW_EPSIZE, 1000))
+    if len(reply) < 2 or reply[0] != payload[0]:
+        sys.exit('unexpected reply, is REMAP_ENABLE on?')
+    if reply[1]:
+        sys.exit(f'keyboard says: {STATUS[reply[1]] if reply[1] < len(STATUS) else reply[1]}')
+    return reply
+
+
+def layer_index(name):
+    if name.upper() in LAYERS:
+        return LAYERS.index(name.upper())
+    return int(name, 0)
+
+
+def keycode(text):
+    if text.upper() in NAMES:
+        return NAMES[text.upper()]
+    return int(text, 0)
+
+
+def info(device):
+    reply = transfer(device, [RAW_REMAP_INFO])
+    return {'layers': reply[2], 'rows': reply[3], 'cols': reply[4], 'remapped': reply[5], 'capacity': reply[6]}
+
+
+def dump(device, layers):
+    layout = info(device)
+    for layer in layers:
+        print(f'{LAYERS[layer] if layer < len(LAYERS) else layer}:')
+        for row in range(layout['rows']):
+            reply = transfer(device, [RAW_REMAP_GET, 0, layer, row])
+            codes = [reply[4 + 2 * col] | reply[5 + 2 * col] << 8 for col in range(layout['cols'])]
+            print(f'  row {row:>2}: ' + ' '.join(f'{CODES.get(code, f"0x{code:04X}"):>8}' for code in codes))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command', required=True)
+    commands.add_parser('info', help='layout and remapped key count')
+    show = commands.add_parser('dump', help='print the live keymap')
+    show.add_argument('--layer', type=layer_index, help='only this layer, by name or number')
+    edit = commands.add_parser('set', help='remap one key')
+    edit.add_argument('layer', type=layer_index)
+    edit.add_argument('row', type=int)
+    edit.add_argument('col', type=int)
+    edit.add_argument('keycode', type=keycode, help='KC_ name or number, e.g. 0x2A or KC_BSPC')
+    clear = commands.add_parser('reset', help='drop remaps, back to the compiled-in keymap')
+    clear.add_argument('--layer', type=layer_index, help='only this layer, by name or number')
+    args = parser.parse_args()
+
+    device = open_device()
+    if args.command == 'info':
+        layout = info(device)
+        print(f'{layout["layers"]} layers of {layout["rows"]}x{layout["cols"]}, {layout["remapped"]}/{layout["capacity"]} keys remapped')
+    elif args.command == 'dump':
+        dump(device, [args.layer] if args.layer is not None else range(info(device)['layers']))
+    elif args.command == 'set':
+        transfer(device, [RAW_REMAP_SET, 0, args.layer, args.row, args.col, args.keycode & 0xFF, args.keycode >> 8])
+        print('remapped, saved within a few seconds')
+    elif args.command == 'reset':
+        transfer(device, [RAW_REMAP_RESET, 0, 0xFF if args.layer is None else args.layer])
+        print('reset, saved within a few seconds')
+    device.close()
+
+
+if __name__ == '__main__':
+    main()
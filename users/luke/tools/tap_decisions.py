@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Aggregate the tap-hold decision dump (TAP_TELEMETRY_ENABLE = yes, STAT_RPT key).
+
+Pipe the console into it, e.g. `qmk console | users/luke/tools/tap_decisions.py`, and press
+STAT_RPT every so often; repeated decisions in overlapping dumps are dropped by sequence
+number. Prints per key and per rule counts, decision latency and suspected misfires:
+
+  hold settled by hold_other/permissive on a press shorter than --short   (a roll, meant tap)
+  tap settled by flow/chordal on a press longer than --long                (meant hold)
+"""
+import argparse
+import sys
+from collections import defaultdict
+
+EARLY_HOLD = ('hold_other', 'permissive')
+EARLY_TAP = ('flow', 'chordal')
+
+
+def percentile(values, percent):
+    values = sorted(values)
+    return values[min(len(values) - 1, len(values) * percent // 100)] if values else 0
+
+
+def misfire(d, args):
+    if d['outcome'] == 'hold' and d['rule'] in EARLY_HOLD:
+        return d['held'] < args.short
+    if d['outcome'] == 'tap' and d['rule'] in EARLY_TAP:
+        return d['held'] > args.long
+    return False
+
+
+def table(title, groups, args):
+    print(f'\n{title:<14} {"n":>6} {"tap%":>6} {"p50":>6} {"p90":>6} {"max":>6} {"misfire%":>9}  decide ms')
+    for name, decisions in sorted(groups.items()):
+        decide = [d['decide'] for d in decisions]
+        taps = sum(d['outcome'] == 'tap' for d in decisions)
+        misfires = sum(misfire(d, args) for d in decisions)
+        n = len(decisions)
+        print(f'{name:<14} {n:>6} {100 * taps / n:>6.1f} {percentile(decide, 50):>6} {percentile(decide, 90):>6} {max(decide):>6} {100 * misfires / n:>9.1f}')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--short', type=int, default=200, help='holds released sooner than this are suspect (default: %(default)s, TAPPING_TERM)')
+    parser.add_argument('--long', type=int, default=300, help='taps held longer than this are suspect (default: %(default)s, HRM_TAPPING_TERM)')
+    args = parser.parse_args()
+
+    seen = {}
+    for line in sys.stdin:
+        fields = line.split()
+        if len(fields) != 10 or fields[0] != 'thd':
+            continue
+        seq, row, col, outcome, rule, decide, held, orow, ocol = fields[1:]
+        seen[int(seq)] = {
+            'key': f'{row},{col}',
+            'outcome': outcome,
+            'rule': rule,
+            'decide': int(decide),
+            'held': int(held),
+            'other': None if orow == '-' else f'{orow},{ocol}',
+        }
+
+    if not seen:
+        sys.exit('no thd lines on stdin, is TAP_TELEMETRY_ENABLE on?')
+
+    by_key, by_rule = defaultdict(list), defaultdict(list)
+    interrupts = defaultdict(lambda: defaultdict(int))
+    for d in seen.values():
+        by_key[d['key']].append(d)
+        by_rule[d['rule']].append(d)
+        if misfire(d, args) and d['other']:
+            interrupts[d['key']][d['other']] += 1
+
+    first, last = min(seen), max(seen)
+    print(f'{len(seen)} decisions, {last - first + 1 - len(seen)} lost between dumps')
+    table('key row,col', by_key, args)
+    table('rule', by_rule, args)
+
+    if interrupts:
+        print('\nmisfires by interrupting key')
+        for key, others in sorted(interrupts.items()):
+            print(f'{key:<14} ' + '  '.join(f'{other} x{count}' for other, count in sorted(others.items(), key=lambda o: -o[1])))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""Typing traces for the replay suites in users/luke/tests (`make test`).
+
+A trace is one key event per line, `<ms> <key> <d|u>`, timed from the start of the trace
+and keyed on the physical key numbers of LAYER_KEYS in layout.h, so the same trace replays
+on every board. See users/luke/tests/README.md.
+
+  capture   turn a console log of a LATENCY_ENABLE build with LATENCY_TRACE defined
+            into a trace: `qmk console > typing.log`, type, then
+            users/luke/tools/traces.py capture typing.log -o tests/traces/mine.trace
+  synth     type a text on the DFLT layer with a simple timing model: rolls at the given
+            speed, releases in press order, capitals on a held home row shift after a
+            pause longer than FLOW_TAP_TERM. Lowercase letters, space and , . ' / only
+"""
+import argparse
+import math
+import os
+import random
+import re
+import sys
+
+LUKE = os.path.realpath(os.path.join(os.path.dirname(__file__), '..'))
+TRACE = re.compile(r'\btrace (\d+) (\d+) ([du])\b')
+
+PUNCTUATION = {'SPC': ' ', 'COMM': ',', 'DOT': '.', 'QUOT': "'", 'SLSH': '/'}
+
+# timing model, ms
+DWELL = (95, 20, 50, 180)       # mean, sd, min, max of a key held down
+SIGMA = 0.35                    # spread of the log-normal gap between presses
+SENTENCE_PAUSE = (450, 900)     # before the first press of a new sentence
+SHIFT_LEAD = (330, 380)         # shift down to the letter, past HRM_TAPPING_TERM
+SHIFT_TAIL = (20, 60)           # letter up to shift up
+
+
+def macro_body(source, name):
+    match = re.search(rf'#define {name}\b(.*?)(?<!\\)\n', source, re.S)
+    body = re.sub(r'/\*.*?\*/', '', match.group(1).replace('\\\n', ' '), flags=re.S)
+    return [token.strip() for token in body.split(',')]
+
+
+def layout():
+    """Key number and modifier of every character the DFLT layer types, from layout.h and luke.h"""
+    with open(os.path.join(LUKE, 'layout.h')) as f:
+        source = f.read()
+    with open(os.path.join(LUKE, 'luke.h')) as f:
+        header = f.read()
+    aliases = dict(re.findall(r'#define (\w+) (?:MT|LT)\(\w+, KC_(\w+)\)', header))
+    mods = dict(re.findall(r'#define (\w+) MT\((MOD_\w+), KC_\w+\)', header))
+
+    keys, shifts = {}, {}
+    for number, token in zip((int(n) for n in macro_body(source, 'LAYER_KEYS')), macro_body(source, 'LAYER_DFLT')):
+        name = aliases.get(token, token[3:] if token.startswith('KC_') else '')
+        char = name.lower() if len(name) == 1 else PUNCTUATION.get(name)
+        # the plain key where a character is on two, KC_QUOT over SYS_QUOT
+        if char and char not in keys:
+            keys[char] = number
+        if mods.get(token) in ('MOD_LSFT', 'MOD_RSFT'):
+            shifts[mods[token]] = number
+    return keys, shifts
+
+
+def left_hand(number):
+    # rows of LAYER_KEYS: 6 + 6, 6 + 6, 7 + 7, 3 + 3
+    return number <= 6 or 13 <= number <= 18 or 25 <= number <= 31 or 39 <= number <= 41
+
+
+def synth(text, wpm, seed):
+    keys, shifts = layout()
+    rng = random.Random(seed)
+    median = 60000 / (wpm * 5)
+    events, free, last_press, last_release = [], {}, -median, 0
+
+    def dwell():
+        mean, sd, low, high = DWELL
+        return int(min(max(rng.gauss(mean, sd), low), high))
+
+    def stroke(key, at, down_for):
+        nonlocal last_release
+        at = max(at, free.get(key, 0))
+        # releases in press order, so no press nests inside another
+        up = max(at + down_for, last_release + 5)
+        events.append((at, key, 'd'))
+        events.append((up, key, 'u'))
+        free[key] = up + 10
+        last_release = up
+        return at, up
+
+    sentence_start = True
+    for char in text:
+        if char.isupper() and not sentence_start:
+            sys.exit(f'capitals only start sentences here: {char!r}')
+        key = keys.get(char.lower())
+        if key is None:
+            sys.exit(f'no key types {char!r} on DFLT')
+
+        gap = median * math.exp(rng.gauss(0, SIGMA))
+        if sentence_start and last_press > 0:
+            gap = max(gap, rng.randint(*SENTENCE_PAUSE))
+        at = int(last_press + gap)
+
+        if char.isupper():
+            # the shift on the other hand, held until it has settled
+            shift = shifts['MOD_RSFT' if left_hand(key) else 'MOD_LSFT']
+            shift_at = max(at, free.get(shift, 0))
+            at, up = stroke(key, shift_at + rng.randint(*SHIFT_LEAD), dwell())
+            shift_up = up + rng.randint(*SHIFT_TAIL)
+            events += [(shift_at, shift, 'd'), (shift_up, shift, 'u')]
+            free[shift] = shift_up + 10
+            last_release = shift_up
+            # the next letter waits for the shift to be up
+            at = shift_up
+        else:
+            at, _ = stroke(key, at, dwell())
+        last_press = at
+        if char == '.':
+            sentence_start = True
+        elif char != ' ':
+            sentence_start = False
+
+    start = min(t for t, _, _ in events)
+    return sorted(((t - start, key, state) for t, key, state in events), key=lambda e: (e[0], e[2] == 'd'))
+
+
+def capture(log):
+    """Events from a console log, the 16 bit timer unwrapped and the first event at 0"""
+    events, base, last = [], 0, None
+    with open(log, errors='replace') as f:
+        for line in f:
+            match = TRACE.search(line)
+            if not match:
+                continue
+            time, key, state = int(match.group(1)), int(match.group(2)), match.group(3)
+            if last is not None and time < last:
+                base += 1 << 16
+            last = time
+            events.append((base + time, key, state))
+    if not events:
+        sys.exit(f'no trace lines in {log}, is LATENCY_TRACE defined?')
+    start = events[0][0]
+    return [(t - start, key, state) for t, key, state in events]
+
+
+def write(out, header, text, events):
+    with open(out, 'w') if out != '-' else sys.stdout as f:
+        f.write(f'# {header}\n')
+        if text:
+            f.write(f'# text: {text}\n')
+        for t, key, state in events:
+            f.write(f'{t} {key} {state}\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command', required=True)
+    cap = commands.add_parser('capture', help='console log to trace')
+    cap.add_argument('log')
+    cap.add_argument('--text', help='what was typed, checked against the host output on replay')
+    syn = commands.add_parser('synth', help='text to trace')
+    syn.add_argument('text')
+    syn.add_argument('--wpm', type=float, default=70, help='typing speed (default: %(default)s)')
+    syn.add_argument('--seed', type=int, default=0)
+    for command in (cap, syn):
+        command.add_argument('-o', '--out', default='-', help='trace file (default: stdout)')
+    args = parser.parse_args()
+
+    if args.command == 'capture':
+        write(args.out, f'captured from {os.path.basename(args.log)}', args.text, capture(args.log))
+    else:
+        events = synth(args.text, args.wpm, args.seed)
+        write(args.out, f'synthesized by tools/traces.py synth --wpm {args.wpm:g} --seed {args.seed}, not a recording', args.text, events)
+
+
+if __name__ == '__main__':
+    main()